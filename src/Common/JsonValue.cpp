@@ -3,7 +3,10 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "JsonValue.h"
-#include <iomanip>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -559,92 +562,309 @@ size_t JsonValue::erase(const Key& key) {
   return getObject().erase(key);
 }
 
-JsonValue JsonValue::fromString(const std::string& source) {
-  JsonValue jsonValue;
-  std::istringstream stream(source);
-  stream >> jsonValue;
-  if (stream.fail()) {
-    throw std::runtime_error("Unable to parse JsonValue");
-  }
-
-  return jsonValue;
-}
-
-JsonValue JsonValue::fromStringWithWhiteSpaces(const std::string& source) {
-  JsonValue jsonValue;
-  std::istringstream stream(source);
-  stream >> std::noskipws >> jsonValue;
-  if (stream.fail()) {
-    throw std::runtime_error("Unable to parse JsonValue");
-  }
-
-  return jsonValue;
-}
-
-std::string JsonValue::toString() const {
-  std::ostringstream stream;
-  stream << *this;
-  return stream.str();
-}
+namespace {
 
-std::ostream& operator<<(std::ostream& out, const JsonValue& jsonValue) {
-  switch (jsonValue.type) {
+void appendValue(std::string& text, const JsonValue& value) {
+  switch (value.getType()) {
   case JsonValue::ARRAY: {
-    const JsonValue::Array& array = *reinterpret_cast<const JsonValue::Array*>(jsonValue.valueArray);
-    out << '[';
-    if (array.size() > 0) {
-      out << array[0];
-      for (size_t i = 1; i < array.size(); ++i) {
-        out << ',' << array[i];
+    const JsonValue::Array& array = value.getArray();
+    text += '[';
+    for (size_t i = 0; i < array.size(); ++i) {
+      if (i != 0) {
+        text += ',';
       }
+
+      appendValue(text, array[i]);
     }
 
-    out << ']';
+    text += ']';
     break;
   }
   case JsonValue::BOOL:
-    out << (jsonValue.valueBool ? "true" : "false");
+    text += value.getBool() ? "true" : "false";
     break;
   case JsonValue::INTEGER:
-    out << jsonValue.valueInteger;
+    appendJsonInteger(text, value.getInteger());
     break;
   case JsonValue::NIL:
-    out << "null";
+    text += "null";
     break;
   case JsonValue::OBJECT: {
-    const JsonValue::Object& object = *reinterpret_cast<const JsonValue::Object*>(jsonValue.valueObject);
-    out << '{';
-    auto iter = object.begin();
-    if (iter != object.end()) {
-      out << '"' << iter->first << "\":" << iter->second;
-      ++iter;
-      for (; iter != object.end(); ++iter) {
-        out << ",\"" << iter->first << "\":" << iter->second;
+    text += '{';
+    bool first = true;
+    for (const auto& member : value.getObject()) {
+      if (!first) {
+        text += ',';
       }
-    }
 
-    out << '}';
-    break;
-  }
-  case JsonValue::REAL: {
-    std::ostringstream stream;
-    stream << std::fixed << std::setprecision(11) << jsonValue.valueReal;
-    std::string value = stream.str();
-    while (value.size() > 1 && value[value.size() - 2] != '.' && value[value.size() - 1] == '0') {
-      value.resize(value.size() - 1);
+      first = false;
+      text += '"';
+      text += member.first;
+      text += "\":";
+      appendValue(text, member.second);
     }
 
-    out << value;
+    text += '}';
     break;
   }
+  case JsonValue::REAL:
+    appendJsonReal(text, value.getReal());
+    break;
   case JsonValue::STRING:
-    out << '"' << *reinterpret_cast<const JsonValue::String*>(jsonValue.valueString) << '"';
+    text += '"';
+    text += value.getString();
+    text += '"';
     break;
   }
+}
+
+// Reads the text in place with the same grammar as operator>>, which reads it char by char from a stream.
+// Without |keepWhiteSpaces| the white spaces in strings are dropped, as a stream skipping them does.
+class JsonParser {
+public:
+  JsonParser(const std::string& source, bool keepWhiteSpaces) :
+    current(source.data()), end(source.data() + source.size()), keepWhiteSpaces(keepWhiteSpaces) {
+  }
+
+  void parse(JsonValue& value) {
+    readValue(value, readNonWsChar());
+  }
+
+private:
+  const char* current;
+  const char* end;
+  bool keepWhiteSpaces;
+
+  static bool isSpace(char c) {
+    return isspace(static_cast<unsigned char>(c)) != 0;
+  }
+
+  static void fail() {
+    throw std::runtime_error("Unable to parse");
+  }
+
+  char readChar() {
+    if (!keepWhiteSpaces) {
+      while (current != end && isSpace(*current)) {
+        ++current;
+      }
+    }
+
+    if (current == end) {
+      throw std::runtime_error("Unable to parse: unexpected end of stream");
+    }
+
+    return *current++;
+  }
+
+  char readNonWsChar() {
+    char c;
+    do {
+      c = readChar();
+    } while (isSpace(c));
+
+    return c;
+  }
+
+  void readStringToken(std::string& value) {
+    for (;;) {
+      char c = readChar();
+      if (c == '"') {
+        break;
+      }
+
+      if (c == '\\') {
+        value += c;
+        c = readChar();
+      }
+
+      value += c;
+    }
+  }
+
+  void readLiteral(const char* rest, size_t size) {
+    if (static_cast<size_t>(end - current) < size || memcmp(current, rest, size) != 0) {
+      fail();
+    }
+
+    current += size;
+  }
+
+  void readValue(JsonValue& value, char c) {
+    if (c == '[') {
+      readArray(value);
+    } else if (c == 't') {
+      readLiteral("rue", 3);
+      value = JsonValue(true);
+    } else if (c == 'f') {
+      readLiteral("alse", 4);
+      value = JsonValue(false);
+    } else if ((c == '-') || (c >= '0' && c <= '9')) {
+      readNumber(value, c);
+    } else if (c == 'n') {
+      readLiteral("ull", 3);
+      value = nullptr;
+    } else if (c == '{') {
+      readObject(value);
+    } else if (c == '"') {
+      std::string text;
+      readStringToken(text);
+      value = std::move(text);
+    } else {
+      fail();
+    }
+  }
+
+  void readArray(JsonValue& value) {
+    JsonValue::Array array;
+    char c = readNonWsChar();
+    if (c != ']') {
+      for (;;) {
+        array.emplace_back();
+        readValue(array.back(), c);
+        c = readNonWsChar();
+        if (c == ']') {
+          break;
+        }
+
+        if (c != ',') {
+          fail();
+        }
+
+        c = readNonWsChar();
+      }
+    }
+
+    value = std::move(array);
+  }
+
+  void readObject(JsonValue& value) {
+    JsonValue::Object object;
+    char c = readNonWsChar();
+    if (c != '}') {
+      std::string name;
+      for (;;) {
+        if (c != '"') {
+          fail();
+        }
+
+        name.clear();
+        readStringToken(name);
+        if (readNonWsChar() != ':') {
+          fail();
+        }
+
+        readValue(object[name], readNonWsChar());
+        c = readNonWsChar();
+        if (c == '}') {
+          break;
+        }
+
+        if (c != ',') {
+          fail();
+        }
+
+        c = readNonWsChar();
+      }
+    }
+
+    value = std::move(object);
+  }
 
+  void readNumber(JsonValue& value, char c) {
+    std::string text(1, c);
+    size_t dots = 0;
+    while (current != end && ((*current >= '0' && *current <= '9') || *current == '.')) {
+      if (*current == '.') {
+        ++dots;
+      }
+
+      text += *current++;
+    }
+
+    if (dots > 0) {
+      if (dots > 1) {
+        fail();
+      }
+
+      if (current != end && *current == 'e') {
+        text += *current++;
+        if (current != end && (*current == '+' || *current == '-')) {
+          text += *current++;
+        }
+
+        if (current == end || *current < '0' || *current > '9') {
+          fail();
+        }
+
+        do {
+          text += *current++;
+        } while (current != end && *current >= '0' && *current <= '9');
+      }
+
+      value = JsonValue::Real(strtod(text.c_str(), nullptr));
+    } else {
+      if (text == "-" || (text.size() > 1 && ((text[0] == '0') || (text[0] == '-' && text[1] == '0')))) {
+        fail();
+      }
+
+      value = JsonValue::Integer(strtoll(text.c_str(), nullptr, 10));
+    }
+  }
+};
+
+}
+
+JsonValue JsonValue::fromString(const std::string& source) {
+  JsonValue jsonValue;
+  JsonParser(source, false).parse(jsonValue);
+  return jsonValue;
+}
+
+JsonValue JsonValue::fromStringWithWhiteSpaces(const std::string& source) {
+  JsonValue jsonValue;
+  JsonParser(source, true).parse(jsonValue);
+  return jsonValue;
+}
+
+std::string JsonValue::toString() const {
+  std::string text;
+  appendValue(text, *this);
+  return text;
+}
+
+std::ostream& operator<<(std::ostream& out, const JsonValue& jsonValue) {
+  out << jsonValue.toString();
   return out;
 }
 
+void appendJsonInteger(std::string& text, JsonValue::Integer value) {
+  char buffer[24];
+  char* end = buffer + sizeof(buffer);
+  char* begin = end;
+  uint64_t absolute = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  do {
+    *--begin = static_cast<char>('0' + absolute % 10);
+    absolute /= 10;
+  } while (absolute != 0);
+
+  if (value < 0) {
+    *--begin = '-';
+  }
+
+  text.append(begin, end);
+}
+
+void appendJsonReal(std::string& text, JsonValue::Real value) {
+  // std::fixed with precision 11, the largest double takes 309 digits before the point
+  char buffer[400];
+  int size = snprintf(buffer, sizeof(buffer), "%.11f", value);
+  while (size > 1 && buffer[size - 2] != '.' && buffer[size - 1] == '0') {
+    --size;
+  }
+
+  text.append(buffer, size);
+}
 
 namespace {
 
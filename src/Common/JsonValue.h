@@ -147,4 +147,8 @@ private:
   void readString(std::istream& in);
 };
 
+// Append the text of a value as operator<< prints it
+void appendJsonInteger(std::string& text, JsonValue::Integer value);
+void appendJsonReal(std::string& text, JsonValue::Real value);
+
 }
@@ -8,6 +8,7 @@
 #include <cstdio>
 #include <boost/foreach.hpp>
 #include "Common/Math.h"
+#include "Common/MemoryInputStream.h"
 #include "Common/ShuffleGenerator.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
@@ -41,6 +42,10 @@ std::string appendPath(const std::string& path, const std::string& fileName) {
   return result;
 }
 
+// the remembered ring signature checks are dropped when there are more of them, normally they are
+// consumed by the pool admission right after the check
+const size_t MAX_VERIFIED_RING_SIGNATURES = 16384;
+
 }
 
 namespace std {
@@ -520,6 +525,8 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
     return false;
   }
 
+  logger(INFO) << "Proof of work scratchpad uses " << Crypto::cn_context::page_mode_name(m_cn_context.pages());
+
   m_config_folder = config_folder;
 
   std::string blockFilePath = appendPath(config_folder, m_currency.blocksFileName());
@@ -1458,6 +1465,235 @@ bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Bloc
   return true;
 }
 
+bool Blockchain::getRawBlocks(uint32_t start_offset, uint32_t count, std::vector<RawBlock>& blocks) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  if (start_offset >= m_blocks.size()) {
+    return false;
+  }
+
+  BinaryArray entryBlob;
+  for (uint32_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++) {
+    RawBlock raw;
+    raw.id = m_blockIndex.getBlockId(i);
+
+    // a cached block is served from memory, the others are cut from the stored bytes
+    const BlockEntry* entry = m_blocks.cached(i);
+    if (entry == nullptr) {
+      m_blocks.getRaw(i, entryBlob);
+      if (splitBlockEntry(entryBlob, raw)) {
+        blocks.push_back(std::move(raw));
+        continue;
+      }
+
+      logger(WARNING) << "Unexpected layout of stored block " << i << ", decoding it";
+      raw.block.clear();
+      raw.transactions.clear();
+      entry = &m_blocks[i];
+    }
+
+    raw.timestamp = entry->bl.timestamp;
+    raw.block = asString(toBinaryArray(entry->bl));
+    raw.transactions.reserve(entry->transactions.size() > 0 ? entry->transactions.size() - 1 : 0);
+    for (size_t t = 1; t < entry->transactions.size(); ++t) {
+      raw.transactions.push_back(asString(toBinaryArray(entry->transactions[t].tx)));
+    }
+
+    blocks.push_back(std::move(raw));
+  }
+
+  return true;
+}
+
+namespace {
+
+// Walks the binary serialization of a block entry. Only the varints and the lengths are read,
+// the block and the transactions are not decoded. Any unexpected byte fails the walk.
+class BlockEntryScanner {
+public:
+  BlockEntryScanner(const uint8_t* data, size_t size) : m_begin(data), m_pos(data), m_end(data + size) {
+  }
+
+  size_t position() const {
+    return m_pos - m_begin;
+  }
+
+  bool varint(uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      if (m_pos == m_end) {
+        return false;
+      }
+
+      uint8_t piece = *m_pos++;
+      value |= static_cast<uint64_t>(piece & 0x7f) << shift;
+      if ((piece & 0x80) == 0) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool skipVarint() {
+    uint64_t value;
+    return varint(value);
+  }
+
+  bool skip(uint64_t size) {
+    if (static_cast<uint64_t>(m_end - m_pos) < size) {
+      return false;
+    }
+
+    m_pos += size;
+    return true;
+  }
+
+  bool byte(uint8_t& value) {
+    if (m_pos == m_end) {
+      return false;
+    }
+
+    value = *m_pos++;
+    return true;
+  }
+
+  // a varint count followed by that many items of |itemSize| bytes
+  bool skipArray(uint64_t itemSize) {
+    uint64_t count;
+    return varint(count) && count <= static_cast<uint64_t>(m_end - m_pos) / itemSize && skip(count * itemSize);
+  }
+
+  bool skipVarintArray(uint64_t& count) {
+    if (!varint(count)) {
+      return false;
+    }
+
+    for (uint64_t i = 0; i < count; ++i) {
+      if (!skipVarint()) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool skipTransaction() {
+    uint64_t inputCount;
+    if (!skipVarint() || !skipVarint() || !varint(inputCount)) {
+      return false;
+    }
+
+    uint64_t signatureCount = 0;
+    for (uint64_t i = 0; i < inputCount; ++i) {
+      uint8_t tag;
+      if (!byte(tag)) {
+        return false;
+      }
+
+      if (tag == 0xff) {
+        if (!skipVarint()) {
+          return false;
+        }
+      } else if (tag == 0x02) {
+        uint64_t outputCount;
+        if (!skipVarint() || !skipVarintArray(outputCount) || !skip(sizeof(Crypto::KeyImage))) {
+          return false;
+        }
+
+        signatureCount += outputCount;
+      } else if (tag == 0x03) {
+        uint64_t requiredSignatures;
+        if (!skipVarint() || !varint(requiredSignatures) || !skipVarint()) {
+          return false;
+        }
+
+        signatureCount += requiredSignatures;
+      } else {
+        return false;
+      }
+    }
+
+    uint64_t outputCount;
+    if (!varint(outputCount)) {
+      return false;
+    }
+
+    for (uint64_t i = 0; i < outputCount; ++i) {
+      uint8_t tag;
+      if (!skipVarint() || !byte(tag)) {
+        return false;
+      }
+
+      if (tag == 0x02) {
+        if (!skip(sizeof(Crypto::PublicKey))) {
+          return false;
+        }
+      } else if (tag == 0x03) {
+        if (!skipArray(sizeof(Crypto::PublicKey)) || !skipVarint()) {
+          return false;
+        }
+      } else {
+        return false;
+      }
+    }
+
+    // extra, then the signatures, which have no count of their own
+    return skipArray(1) && signatureCount <= static_cast<uint64_t>(m_end - m_pos) / sizeof(Crypto::Signature) &&
+      skip(signatureCount * sizeof(Crypto::Signature));
+  }
+
+  bool atEnd() const {
+    return m_pos == m_end;
+  }
+
+private:
+  const uint8_t* m_begin;
+  const uint8_t* m_pos;
+  const uint8_t* m_end;
+};
+
+}
+
+bool Blockchain::splitBlockEntry(const BinaryArray& entryBlob, RawBlock& raw) {
+  BlockEntryScanner scanner(entryBlob.data(), entryBlob.size());
+  const char* data = reinterpret_cast<const char*>(entryBlob.data());
+
+  // the entry holds the block and then its transactions, each one followed by its output indexes
+  uint64_t majorVersion;
+  uint64_t transactionCount;
+  if (!scanner.varint(majorVersion) || majorVersion > BLOCK_MAJOR_VERSION_1 || !scanner.skipVarint() ||
+      !scanner.varint(raw.timestamp) || !scanner.skip(sizeof(Crypto::Hash) + sizeof(uint32_t)) ||
+      !scanner.skipTransaction() || !scanner.skipArray(sizeof(Crypto::Hash))) {
+    return false;
+  }
+
+  raw.block.assign(data, scanner.position());
+  if (!scanner.skipVarint() || !scanner.skipVarint() || !scanner.skipVarint() || !scanner.skipVarint() ||
+      !scanner.varint(transactionCount)) {
+    return false;
+  }
+
+  raw.transactions.reserve(transactionCount > 0 ? static_cast<size_t>(std::min<uint64_t>(transactionCount, entryBlob.size())) - 1 : 0);
+  for (uint64_t t = 0; t < transactionCount; ++t) {
+    size_t begin = scanner.position();
+    uint64_t indexCount;
+    if (!scanner.skipTransaction()) {
+      return false;
+    }
+
+    // the first one is the base transaction, it is a part of the block already
+    if (t != 0) {
+      raw.transactions.emplace_back(data + begin, scanner.position() - begin);
+    }
+
+    if (!scanner.skipVarintArray(indexCount)) {
+      return false;
+    }
+  }
+
+  return scanner.atEnd();
+}
+
 bool Blockchain::handleGetObjects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   rsp.current_blockchain_height = (uint32_t)getCurrentBlockchainHeight(); // in protocol as 32bit
@@ -1894,9 +2130,84 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
     return true;
   }
 
+  {
+    std::lock_guard<std::mutex> verifiedLock(m_verifiedRingSignaturesLock);
+    if (m_verifiedRingSignatures.erase(ringSignatureId(txin, tx_prefix_hash, output_keys, sig)) != 0) {
+      return true;
+    }
+  }
+
   return Crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
 }
 
+Crypto::Hash Blockchain::ringSignatureId(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<const Crypto::PublicKey*>& output_keys, const std::vector<Crypto::Signature>& sig) {
+  // everything check_ring_signature depends on
+  BinaryArray data;
+  data.reserve(sizeof(Crypto::Hash) + sizeof(Crypto::KeyImage) + output_keys.size() * sizeof(Crypto::PublicKey) + sig.size() * sizeof(Crypto::Signature));
+  data.insert(data.end(), tx_prefix_hash.data, tx_prefix_hash.data + sizeof(tx_prefix_hash));
+  data.insert(data.end(), txin.keyImage.data, txin.keyImage.data + sizeof(txin.keyImage));
+  for (const Crypto::PublicKey* key : output_keys) {
+    data.insert(data.end(), key->data, key->data + sizeof(*key));
+  }
+
+  const uint8_t* signatures = reinterpret_cast<const uint8_t*>(sig.data());
+  data.insert(data.end(), signatures, signatures + sig.size() * sizeof(Crypto::Signature));
+  return Crypto::cn_fast_hash(data.data(), data.size());
+}
+
+void Blockchain::preverifyRingSignatures(const Transaction& tx, const Crypto::Hash& tx_prefix_hash) {
+  struct OutputKeysCopier {
+    std::vector<Crypto::PublicKey>& keys;
+
+    bool handle_output(const Transaction& tx, const TransactionOutput& out, size_t transactionOutputIndex) {
+      if (out.target.type() != typeid(KeyOutput)) {
+        return false;
+      }
+
+      keys.push_back(boost::get<KeyOutput>(out.target).key);
+      return true;
+    }
+  };
+
+  if (isInCheckpointZone(getCurrentBlockchainHeight()) || tx.signatures.size() != tx.inputs.size()) {
+    return;
+  }
+
+  for (size_t i = 0; i < tx.inputs.size(); ++i) {
+    if (tx.inputs[i].type() != typeid(KeyInput)) {
+      continue;
+    }
+
+    const KeyInput& txin = boost::get<KeyInput>(tx.inputs[i]);
+    const std::vector<Crypto::Signature>& sig = tx.signatures[i];
+
+    // the keys are copied under the blockchain lock, the signature is checked without it
+    std::vector<Crypto::PublicKey> keys;
+    OutputKeysCopier copier{ keys };
+    if (!scanOutputKeysForIndexes(txin, copier) || keys.size() != txin.outputIndexes.size() || keys.size() != sig.size()) {
+      return;
+    }
+
+    std::vector<const Crypto::PublicKey*> output_keys;
+    output_keys.reserve(keys.size());
+    for (const Crypto::PublicKey& key : keys) {
+      output_keys.push_back(&key);
+    }
+
+    if (!Crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data())) {
+      return;
+    }
+
+    Crypto::Hash id = ringSignatureId(txin, tx_prefix_hash, output_keys, sig);
+    std::lock_guard<std::mutex> verifiedLock(m_verifiedRingSignaturesLock);
+    if (m_verifiedRingSignatures.size() >= MAX_VERIFIED_RING_SIGNATURES) {
+      m_verifiedRingSignatures.clear();
+    }
+
+    m_verifiedRingSignatures.insert(id);
+  }
+}
+
 uint64_t Blockchain::get_adjusted_time() {
   //TODO: add collecting median time
   return time(NULL);
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>
+#include <unordered_set>
 
 #include "google/sparse_hash_set"
 #include "google/sparse_hash_map"
@@ -66,6 +68,20 @@ namespace CryptoNote {
     void setCheckpoints(Checkpoints&& chk_pts) { m_checkpoints = chk_pts; }
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks, std::list<Transaction>& txs);
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks);
+
+    // block and its transactions (without the base one) serialized as on the wire
+    struct RawBlock {
+      Crypto::Hash id;
+      uint64_t timestamp;
+      std::string block;
+      std::vector<std::string> transactions;
+    };
+
+    // Reads main chain blocks. Cached blocks are serialized from memory, the others are cut
+    // from the bytes of the block storage without decoding them and are not cached.
+    bool getRawBlocks(uint32_t start_offset, uint32_t count, std::vector<RawBlock>& blocks);
+    // cuts a stored block entry into the block and transaction blobs without decoding them
+    static bool splitBlockEntry(const BinaryArray& entryBlob, RawBlock& raw);
     bool getAlternativeBlocks(std::list<Block>& blocks);
     uint32_t getAlternativeBlocksCount();
     Crypto::Hash getBlockIdByHeight(uint32_t height);
@@ -114,6 +130,9 @@ namespace CryptoNote {
     bool getTransactionIdsByPaymentId(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionHashes);
     bool isBlockInMainChain(const Crypto::Hash& blockId);
     bool isInCheckpointZone(const uint32_t height);
+    // checks the ring signatures of the transaction without holding the blockchain lock, the
+    // successful checks are remembered and skipped by checkTransactionInputs
+    void preverifyRingSignatures(const Transaction& tx, const Crypto::Hash& tx_prefix_hash);
 
     template<class visitor_t> bool scanOutputKeysForIndexes(const KeyInput& tx_in_to_key, visitor_t& vis, uint32_t* pmax_related_block_height = NULL);
 
@@ -241,6 +260,8 @@ namespace CryptoNote {
     const Currency& m_currency;
     tx_memory_pool& m_tx_pool;
     std::recursive_mutex m_blockchain_lock; // TODO: add here reader/writer lock
+    std::mutex m_verifiedRingSignaturesLock;
+    std::unordered_set<Crypto::Hash> m_verifiedRingSignatures;
     Crypto::cn_context m_cn_context;
     Tools::ObserverManager<IBlockchainStorageObserver> m_observerManager;
 
@@ -304,6 +325,7 @@ namespace CryptoNote {
     std::vector<Crypto::Hash> doBuildSparseChain(const Crypto::Hash& startBlockId) const;
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_comulative_size_limit();
+    Crypto::Hash ringSignatureId(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<const Crypto::PublicKey*>& output_keys, const std::vector<Crypto::Signature>& sig);
     bool check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL);
     bool checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL);
     bool checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height = NULL);
@@ -4,7 +4,9 @@
 
 #include "Core.h"
 
+#include <future>
 #include <sstream>
+#include <thread>
 #include <unordered_set>
 #include "../CryptoNoteConfig.h"
 #include "../Common/CommandLine.h"
@@ -127,6 +129,10 @@ bool core::init(const CoreConfig& config, const MinerConfig& minerConfig, bool l
   m_config_folder = config.configFolder;
 
   //logger(INFO) << "Initialize memory pool...";
+  if (config.mempoolMaxSize != 0) {
+    m_mempool.setMaxSize(config.mempoolMaxSize);
+  }
+
   bool r = m_mempool.init(m_config_folder);
   if (!(r)) { logger(ERROR, BRIGHT_RED) << "Failed to initialize memory pool"; return false; }
 
@@ -230,7 +236,7 @@ bool core::handle_incoming_tx(const BinaryArray& tx_blob, tx_verification_contex
   uint32_t blockHeight;
   bool ok = getBlockContainingTx(tx_hash, blockId, blockHeight);
   if (!ok) blockHeight = this->get_current_blockchain_height(); //this assumption fails for withdrawals
-  return handleIncomingTransaction(tx, tx_hash, tx_blob.size(), tvc, keeped_by_block, blockHeight);
+  return processIncomingTransaction(tx, tx_hash, tx_blob.size(), tvc, keeped_by_block, blockHeight, &tx_blob);
 }
 
 bool core::get_stat_info(core_stat_info& st_inf) {
@@ -431,7 +437,7 @@ bool core::transactionByOrdinal(uint64_t ordinalBlock, uint64_t ordinalTransacti
 //  return m_blockchain.get_outs(amount, pkeys);
 //}
 
-bool core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, uint32_t height) {
+bool core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, uint32_t height, const BinaryArray* txBlob) {
   //Locking on m_mempool and m_blockchain closes possibility to add tx to memory pool which is already in blockchain 
   std::lock_guard<decltype(m_mempool)> lk(m_mempool);
   LockedBlockchainStorage lbs(m_blockchain);
@@ -448,7 +454,7 @@ bool core::add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t
 
   logger(DEBUGGING) << "calling m_mempool.add_tx...";
 
-  return m_mempool.add_tx(tx, tx_hash, blob_size, tvc, keeped_by_block, height);
+  return m_mempool.add_tx(tx, tx_hash, blob_size, tvc, keeped_by_block, height, txBlob);
 }
 
 uint64_t core::getcurrentmediansize() {
@@ -830,26 +836,19 @@ bool core::queryBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t
     return true;
   }
 
-  std::list<Block> blocks;
-  lbs->getBlocks(startFullOffset, blocksLeft, blocks);
+  std::vector<Blockchain::RawBlock> blocks;
+  lbs->getRawBlocks(startFullOffset, blocksLeft, blocks);
 
   for (auto& b : blocks) {
     BlockFullInfo item;
 
-    item.block_id = get_block_hash(b);
+    item.block_id = b.id;
 
     if (b.timestamp >= timestamp) {
-      // query transactions
-      std::list<Transaction> txs;
-      std::list<Crypto::Hash> missedTxs;
-      lbs->getTransactions(b.transactionHashes, txs, missedTxs);
-
       // fill data
       block_complete_entry& completeEntry = item;
-      completeEntry.block = asString(toBinaryArray(b));
-      for (auto& tx : txs) {
-        completeEntry.txs.push_back(asString(toBinaryArray(tx)));
-      }
+      completeEntry.block = std::move(b.block);
+      completeEntry.txs = std::move(b.transactions);
     }
 
     entries.push_back(std::move(item));
@@ -892,6 +891,22 @@ std::vector<Crypto::Hash> core::findIdsForShortBlocks(uint32_t startOffset, uint
   return result;
 }
 
+bool core::findBlocksToQuery(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& resStartHeight,
+  uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<Crypto::Hash>& shortBlockIds) {
+  LockedBlockchainStorage lbs(m_blockchain);
+
+  resCurrentHeight = lbs->getCurrentBlockchainHeight();
+  resStartHeight = 0;
+  resFullOffset = 0;
+
+  if (!findStartAndFullOffsets(knownBlockIds, timestamp, resStartHeight, resFullOffset)) {
+    return false;
+  }
+
+  shortBlockIds = findIdsForShortBlocks(resStartHeight, resFullOffset);
+  return true;
+}
+
 bool core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& resStartHeight,
   uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries) {
   LockedBlockchainStorage lbs(m_blockchain);
@@ -1138,6 +1153,10 @@ uint64_t core::getTotalGeneratedAmount() {
 }
 
 bool core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) {
+  return processIncomingTransaction(tx, txHash, blobSize, tvc, keptByBlock, height, nullptr);
+}
+
+bool core::processIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height, const BinaryArray* txBlob) {
 
   logger(DEBUGGING) << "handleIncomingTransaction...";
 
@@ -1149,6 +1168,95 @@ bool core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash&
 
   logger(DEBUGGING) << "checkpoints...";
 
+  if (!check_tx_limits(tx, txHash, blobSize, tvc)) {
+    return false;
+  }
+
+  logger(DEBUGGING) << "check semantic";
+
+  if (!check_tx_semantic(tx, keptByBlock)) {
+    logger(INFO) << "WRONG TRANSACTION BLOB, Failed to check tx " << txHash << " semantic, rejected";
+    tvc.m_verifivation_failed = true;
+    return false;
+  }
+
+  bool r = addIncomingTransaction(tx, txHash, blobSize, tvc, keptByBlock, height, txBlob);
+  if (tvc.m_added_to_pool) {
+    poolUpdated();
+  }
+
+  logger(DEBUGGING) << "incoming transaction processed... success";
+
+  return r;
+}
+
+bool core::handle_incoming_txs(const std::vector<BinaryArray>& tx_blobs, std::vector<tx_verification_context>& tvcs) {
+  struct IncomingTransaction {
+    Transaction tx;
+    Crypto::Hash hash;
+    bool checked;
+  };
+
+  tvcs.assign(tx_blobs.size(), boost::value_initialized<tx_verification_context>());
+  std::vector<IncomingTransaction> incoming(tx_blobs.size());
+
+  // parsing, the checks not related with database and the ring signatures, which need the
+  // blockchain lock only to read the output keys, are spread over all cores
+  size_t workers = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), tx_blobs.size()));
+  std::vector<std::future<void>> checkingThreads;
+  for (size_t worker = 0; worker < workers; ++worker) {
+    checkingThreads.push_back(std::async(std::launch::async, [this, &tx_blobs, &incoming, workers, worker] {
+      for (size_t i = worker; i < tx_blobs.size(); i += workers) {
+        IncomingTransaction& item = incoming[i];
+        Crypto::Hash prefixHash;
+        item.checked = tx_blobs[i].size() <= m_currency.maxTxSize() &&
+          parse_tx_from_blob(item.tx, item.hash, prefixHash, tx_blobs[i]) &&
+          check_tx_syntax(item.tx) &&
+          check_tx_semantic(item.tx, false);
+        if (item.checked) {
+          m_blockchain.preverifyRingSignatures(item.tx, prefixHash);
+        }
+      }
+    }));
+  }
+
+  for (auto& thread : checkingThreads) {
+    thread.get();
+  }
+
+  // pool admission stays sequential, every transaction is added atomically under the pool lock
+  bool poolChanged = false;
+  for (size_t i = 0; i < incoming.size(); ++i) {
+    IncomingTransaction& item = incoming[i];
+    tx_verification_context& tvc = tvcs[i];
+    if (!item.checked) {
+      logger(INFO) << "WRONG TRANSACTION BLOB, Failed to check transaction #" << i << " of the batch, rejected";
+      tvc.m_verifivation_failed = true;
+      continue;
+    }
+
+    if (!check_tx_limits(item.tx, item.hash, tx_blobs[i].size(), tvc)) {
+      continue;
+    }
+
+    Crypto::Hash blockId;
+    uint32_t blockHeight;
+    if (!getBlockContainingTx(item.hash, blockId, blockHeight)) {
+      blockHeight = get_current_blockchain_height();
+    }
+
+    addIncomingTransaction(item.tx, item.hash, tx_blobs[i].size(), tvc, false, blockHeight, &tx_blobs[i]);
+    poolChanged = poolChanged || tvc.m_added_to_pool;
+  }
+
+  if (poolChanged) {
+    poolUpdated();
+  }
+
+  return true;
+}
+
+bool core::check_tx_limits(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc) {
   // is not in checkpoint zone
   if (!m_blockchain.isInCheckpointZone(get_current_blockchain_height())) {
     if (blobSize > m_currency.maxTxSize()) {
@@ -1165,17 +1273,13 @@ bool core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash&
     }
   }
 
-  logger(DEBUGGING) << "check semantic";
-
-  if (!check_tx_semantic(tx, keptByBlock)) {
-    logger(INFO) << "WRONG TRANSACTION BLOB, Failed to check tx " << txHash << " semantic, rejected";
-    tvc.m_verifivation_failed = true;
-    return false;
-  }
+  return true;
+}
 
+bool core::addIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height, const BinaryArray* txBlob) {
   logger(DEBUGGING) << "Core.cpp handleIncomingTransaction: calling add_new_tx: " << txHash;
 
-  bool r = add_new_tx(tx, txHash, blobSize, tvc, keptByBlock, height);
+  bool r = add_new_tx(tx, txHash, blobSize, tvc, keptByBlock, height, txBlob);
   if (tvc.m_verifivation_failed) {
     if (!tvc.m_tx_fee_too_small) {
       logger(ERROR) << "Transaction verification failed: " << txHash;
@@ -1185,12 +1289,6 @@ bool core::handleIncomingTransaction(const Transaction& tx, const Crypto::Hash&
   } else if (tvc.m_verifivation_impossible) {
     logger(INFO) << "Transaction verification impossible: " << txHash << " result: " << r;
   }
- 
-  if (tvc.m_added_to_pool) {
-    poolUpdated();
-  }
-
-  logger(DEBUGGING) << "incoming transaction processed... success";
 
   return r;
 }
@@ -1219,6 +1317,10 @@ std::unique_ptr<IBlock> core::getBlock(const Crypto::Hash& blockId) {
   //return std::move(blockPtr);
 }
 
+bool core::getRawBlocks(uint32_t startIndex, uint32_t count, std::vector<Blockchain::RawBlock>& blocks) {
+  return m_blockchain.getRawBlocks(startIndex, count, blocks);
+}
+
 bool core::addMessageQueue(MessageQueue<BlockchainMessage>& messageQueue) {
   return m_blockchain.addMessageQueue(messageQueue);
 }
@@ -40,6 +40,8 @@ namespace CryptoNote {
 
      bool on_idle() override;
      virtual bool handle_incoming_tx(const BinaryArray& tx_blob, tx_verification_context& tvc, bool keeped_by_block) override; //Deprecated. Should be removed with CryptoNoteProtocolHandler.
+     //parses and checks the transactions in parallel, then adds them to the pool one by one
+     bool handle_incoming_txs(const std::vector<BinaryArray>& tx_blobs, std::vector<tx_verification_context>& tvcs);
      bool handle_incoming_block_blob(const BinaryArray& block_blob, block_verification_context& bvc, bool control_miner, bool relay_block) override;
      virtual i_cryptonote_protocol* get_protocol() override {return m_pprotocol;}
      const Currency& currency() const { return m_currency; }
@@ -85,6 +87,10 @@ namespace CryptoNote {
 
      virtual bool getOutByMSigGIndex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out) override;
      virtual std::unique_ptr<IBlock> getBlock(const Crypto::Hash& blocksId) override;
+     bool getRawBlocks(uint32_t startIndex, uint32_t count, std::vector<Blockchain::RawBlock>& blocks);
+     // the first part of queryBlocks: ids of the blocks sent without contents, the rest is read from |resFullOffset|
+     bool findBlocksToQuery(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& resStartHeight,
+       uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<Crypto::Hash>& shortBlockIds);
      virtual bool handleIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) override;
      virtual std::error_code executeLocked(const std::function<std::error_code()>& func) override;
      
@@ -166,12 +172,16 @@ namespace CryptoNote {
      uint64_t getTotalGeneratedAmount();
 
    private:
-     bool add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, uint32_t height);
+     bool add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, uint32_t height, const BinaryArray* txBlob = nullptr);
      bool load_state_data();
      bool parse_tx_from_blob(Transaction& tx, Crypto::Hash& tx_hash, Crypto::Hash& tx_prefix_hash, const BinaryArray& blob);
      bool handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block);
 
      bool check_tx_syntax(const Transaction& tx);
+     bool check_tx_limits(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc);
+     // |txBlob| is optional, the pool journals it instead of serializing |tx| again
+     bool processIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height, const BinaryArray* txBlob);
+     bool addIncomingTransaction(const Transaction& tx, const Crypto::Hash& txHash, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height, const BinaryArray* txBlob = nullptr);
 
      // new checks added by Karbo
      //check if tx already in memory pool or in main blockchain
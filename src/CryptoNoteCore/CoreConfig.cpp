@@ -7,8 +7,17 @@
 #include "Common/Util.h"
 #include "Common/CommandLine.h"
 
+#include <stdexcept>
+
 namespace CryptoNote {
 
+namespace {
+// below this the pool could not hold even a handful of large transactions and would keep evicting
+const uint64_t MEMPOOL_MIN_SIZE_MB = 8;
+
+const command_line::arg_descriptor<uint64_t> arg_mempool_max_size = {"mempool-max-size", "Specify memory limit for the transaction pool, in megabytes (0 - default, otherwise at least 8)", 0};
+}
+
 CoreConfig::CoreConfig() {
   configFolder = Tools::getDefaultDataDirectory();
 }
@@ -18,8 +27,18 @@ void CoreConfig::init(const boost::program_options::variables_map& options) {
     configFolder = command_line::get_arg(options, command_line::arg_data_dir);
     configFolderDefaulted = options[command_line::arg_data_dir.name].defaulted();
   }
+
+  if (command_line::has_arg(options, arg_mempool_max_size)) {
+    uint64_t mempoolMaxSizeMb = command_line::get_arg(options, arg_mempool_max_size);
+    if (mempoolMaxSizeMb != 0 && mempoolMaxSizeMb < MEMPOOL_MIN_SIZE_MB) {
+      throw std::runtime_error("--" + std::string(arg_mempool_max_size.name) + " must be 0 or at least " + std::to_string(MEMPOOL_MIN_SIZE_MB) + " MB");
+    }
+
+    mempoolMaxSize = mempoolMaxSizeMb * 1024 * 1024;
+  }
 }
 
 void CoreConfig::initOptions(boost::program_options::options_description& desc) {
+  command_line::add_arg(desc, arg_mempool_max_size);
 }
 } //namespace CryptoNote
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include <boost/program_options.hpp>
@@ -19,6 +20,7 @@ public:
 
   std::string configFolder;
   bool configFolderDefaulted = true;
+  uint64_t mempoolMaxSize = 0; // 0 - use currency default
 };
 
 } //namespace CryptoNote
@@ -505,6 +505,25 @@ bool get_block_longhash(cn_context &context, const Block& b, Hash& res, uint32_t
   return true;
 }
 
+bool get_block_longhashes(cn_context *const *contexts, const Block *blocks, Hash *res, size_t count) {
+  if (count == 0 || count > CN_SLOW_HASH_MAX_WAYS) {
+    return false;
+  }
+
+  BinaryArray bd[CN_SLOW_HASH_MAX_WAYS];
+  const void *data[CN_SLOW_HASH_MAX_WAYS];
+  for (size_t i = 0; i < count; ++i) {
+    if (!get_block_hashing_blob(blocks[i], bd[i]) || bd[i].size() != bd[0].size()) {
+      return false;
+    }
+
+    data[i] = bd[i].data();
+  }
+
+  cn_slow_hash_multi(blocks[0].majorVersion, contexts, data, bd[0].size(), res, count);
+  return true;
+}
+
 std::vector<uint32_t> relative_output_offsets_to_absolute(const std::vector<uint32_t>& off) {
   std::vector<uint32_t> res = off;
   for (size_t i = 1; i < res.size(); i++)
@@ -5,6 +5,7 @@
 #include "Miner.h"
 
 #include <future>
+#include <memory>
 #include <numeric>
 #include <sstream>
 #include <thread>
@@ -259,25 +260,36 @@ namespace CryptoNote
       std::atomic<bool> found(false);
       uint32_t startNonce = Crypto::rand<uint32_t>();
 
+      // several nonces are hashed at once per thread when the cache holds a scratchpad for each of them
+      size_t ways = Crypto::cn_slow_hash_ways(nthreads);
+
       for (unsigned i = 0; i < nthreads; ++i) {
         threads[i] = std::async(std::launch::async, [&, i]() {
-          Crypto::cn_context localctx;
-          Crypto::Hash h;
-
-          Block lb(bl); // copy to local block
+          std::vector<std::unique_ptr<Crypto::cn_context>> localctxs;
+          Crypto::cn_context* contexts[Crypto::CN_SLOW_HASH_MAX_WAYS];
+          Block lbs[Crypto::CN_SLOW_HASH_MAX_WAYS]; // copies of the block, one per nonce
+          Crypto::Hash h[Crypto::CN_SLOW_HASH_MAX_WAYS];
+          for (size_t k = 0; k < ways; ++k) {
+            localctxs.emplace_back(new Crypto::cn_context());
+            contexts[k] = localctxs.back().get();
+            lbs[k] = bl;
+          }
 
-          for (uint32_t nonce = startNonce + i; !found; nonce += nthreads) {
-            lb.nonce = nonce;
+          for (uint32_t nonce = startNonce + i; !found; nonce += static_cast<uint32_t>(ways) * nthreads) {
+            for (size_t k = 0; k < ways; ++k) {
+              lbs[k].nonce = nonce + static_cast<uint32_t>(k) * nthreads;
+            }
 
-            uint32_t extrahashID=0;
-            if (!get_block_longhash(localctx, lb, h, extrahashID)) {
+            if (!get_block_longhashes(contexts, lbs, h, ways)) {
               return;
             }
 
-            if (check_hash(h, diffic)) {
-              foundNonce = nonce;
-              found = true;
-              return;
+            for (size_t k = 0; k < ways; ++k) {
+              if (check_hash(h[k], diffic)) {
+                foundNonce = lbs[k].nonce;
+                found = true;
+                return;
+              }
             }
           }
         });
@@ -357,6 +369,8 @@ namespace CryptoNote
     Crypto::cn_context context;
     Block b;
 
+    logger(DEBUGGING) << "Miner thread [" << th_local_index << "] scratchpad uses " << Crypto::cn_context::page_mode_name(context.pages());
+
     while(!m_stop)
     {
       if(m_pausers_count) //anti split workaround
@@ -146,6 +146,10 @@ public:
   const T& operator[](uint64_t index);
   const T& front();
   const T& back();
+  // serialized item as stored in the items file, the cache is neither used nor updated
+  void getRaw(uint64_t index, std::vector<uint8_t>& blob);
+  // the item if it is in the cache, nullptr otherwise; the cache order is kept
+  const T* cached(uint64_t index) const;
   void clear();
   void pop_back();
   void push_back(const T& item);
@@ -330,6 +334,29 @@ template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
   return *item;
 }
 
+template<class T> void SwappedVector<T>::getRaw(uint64_t index, std::vector<uint8_t>& blob) {
+  if (index >= m_offsets.size()) {
+    throw std::runtime_error("SwappedVector::getRaw");
+  }
+
+  if (!m_itemsFile) {
+    throw std::runtime_error("SwappedVector::getRaw");
+  }
+
+  uint64_t end = index + 1 < m_offsets.size() ? m_offsets[index + 1] : m_itemsFileSize;
+  blob.resize(static_cast<size_t>(end - m_offsets[index]));
+  m_itemsFile.seekg(m_offsets[index]);
+  m_itemsFile.read(reinterpret_cast<char*>(blob.data()), blob.size());
+  if (!m_itemsFile) {
+    throw std::runtime_error("SwappedVector::getRaw");
+  }
+}
+
+template<class T> const T* SwappedVector<T>::cached(uint64_t index) const {
+  auto itemIter = m_items.find(index);
+  return itemIter != m_items.end() ? &itemIter->second.item : nullptr;
+}
+
 template<class T> const T& SwappedVector<T>::front() {
   return operator[](0);
 }
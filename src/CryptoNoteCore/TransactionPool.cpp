@@ -20,6 +20,8 @@
 
 #include <algorithm>
 #include <ctime>
+#include <future>
+#include <thread>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
@@ -101,6 +103,36 @@ namespace CryptoNote {
 
   std::unordered_set<Crypto::Hash> m_validated_transactions;
 
+  namespace {
+
+  // Approximate heap footprint of a pool entry: the deserialized transaction,
+  // its multi_index node and its records in the spent key images/outputs containers
+  uint64_t getTransactionMemoryUsage(const Transaction& tx, uint64_t blobSize) {
+    const uint64_t nodeOverhead = 4 * sizeof(void*);
+
+    uint64_t usage = sizeof(tx_memory_pool::PoolTransactionDetails) + 2 * nodeOverhead;
+    usage += tx.extra.size();
+    usage += tx.inputs.size() * sizeof(TransactionInput);
+    usage += tx.outputs.size() * sizeof(TransactionOutput);
+
+    for (const auto& in : tx.inputs) {
+      if (in.type() == typeid(KeyInput)) {
+        usage += boost::get<KeyInput>(in).outputIndexes.size() * sizeof(uint32_t);
+        usage += sizeof(Crypto::KeyImage) + sizeof(std::unordered_set<Crypto::Hash>) + sizeof(Crypto::Hash) + 2 * nodeOverhead;
+      } else if (in.type() == typeid(MultisignatureInput)) {
+        usage += sizeof(std::pair<uint64_t, uint64_t>) + nodeOverhead;
+      }
+    }
+
+    for (const auto& signatures : tx.signatures) {
+      usage += sizeof(signatures) + signatures.size() * sizeof(Crypto::Signature);
+    }
+
+    return std::max(usage, blobSize);
+  }
+
+  }
+
   //---------------------------------------------------------------------------------
   tx_memory_pool::tx_memory_pool(
     const CryptoNote::Currency& currency,
@@ -112,15 +144,18 @@ namespace CryptoNote {
     m_currency(currency),
     //m_core(core),
     m_txCheckInterval(60, timeProvider),
+    m_log(log),
     m_validator(validator),
     m_timeProvider(timeProvider),
     m_fee_index(boost::get<1>(m_transactions)),
+    m_memoryUsage(0),
+    m_maxSize(currency.mempoolMaxSize()),
     logger(log, "txpool"),
     m_paymentIdIndex(blockchainIndexesEnabled),
     m_timestampIndex(blockchainIndexesEnabled) {
   }
   //---------------------------------------------------------------------------------
-  bool tx_memory_pool::add_tx(const Transaction &tx, /*const Crypto::Hash& tx_prefix_hash,*/ const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) {
+  bool tx_memory_pool::add_tx(const Transaction &tx, /*const Crypto::Hash& tx_prefix_hash,*/ const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height, const BinaryArray* txBlob) {
 
     if (!check_inputs_types_supported(tx)) {
       logger(INFO) << "unsupported type";
@@ -146,10 +181,19 @@ namespace CryptoNote {
 
     const uint64_t fee = inputs_amount - outputs_amount;
     bool isFusionTransaction = fee == 0 && m_currency.isFusionTransaction(tx, blobSize);
+    const uint64_t memoryUsage = getTransactionMemoryUsage(tx, blobSize);
 
     //check key images for transaction if it is not kept by block
     if (!keptByBlock) {
       std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+      if (!isAdmissibleBySize(fee, blobSize, memoryUsage)) {
+        logger(DEBUGGING) << "Memory pool is full, transaction with id= " << id << " has too low fee per byte. Ignore";
+        tvc.m_verifivation_failed = false;
+        tvc.m_should_be_relayed = false;
+        tvc.m_added_to_pool = false;
+        return true;
+      }
+
       if (haveSpentInputs(tx)) {
         logger(INFO) << "Transaction with id= " << id << " used already spent inputs";
         tvc.m_verifivation_failed = true;
@@ -213,6 +257,23 @@ namespace CryptoNote {
       }
       m_paymentIdIndex.add(tx);
       m_timestampIndex.add(txd.receiveTime, txd.id);
+      m_memoryUsage += memoryUsage;
+
+      if (m_log.isOpen()) {
+        TransactionPoolLog::AddRecordHeader record;
+        record.id = txd.id;
+        record.blobSize = txd.blobSize;
+        record.fee = txd.fee;
+        record.keptByBlock = txd.keptByBlock;
+        record.receiveTime = static_cast<uint64_t>(txd.receiveTime);
+        record.maxUsedBlock = txd.maxUsedBlock;
+        record.lastFailedBlock = txd.lastFailedBlock;
+        if (txBlob != nullptr) {
+          m_log.appendAdd(record, *txBlob);
+        } else {
+          m_log.appendAdd(record, toBinaryArray(tx));
+        }
+      }
     }
 
     tvc.m_added_to_pool = true;
@@ -225,6 +286,16 @@ namespace CryptoNote {
     }
 
     tvc.m_verifivation_failed = false;
+
+    if (m_memoryUsage > m_maxSize && evictLowFeeTransactions()) {
+      if (m_transactions.count(id) == 0) {
+        tvc.m_added_to_pool = false;
+        tvc.m_should_be_relayed = false;
+      }
+
+      m_observerManager.notify(&ITxPoolObserver::txDeletedFromPool);
+    }
+
     return true; // success
   }
 
@@ -278,6 +349,21 @@ namespace CryptoNote {
     return m_transactions.size();
   }
   //---------------------------------------------------------------------------------
+  uint64_t tx_memory_pool::getMemoryUsage() const {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    return m_memoryUsage;
+  }
+  //---------------------------------------------------------------------------------
+  uint64_t tx_memory_pool::getMaxSize() const {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    return m_maxSize;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::setMaxSize(uint64_t maxSize) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    m_maxSize = maxSize;
+  }
+  //---------------------------------------------------------------------------------
   void tx_memory_pool::get_transactions(std::list<Transaction>& txs) const {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
     for (const auto& tx_vt : m_transactions) {
@@ -515,48 +601,175 @@ namespace CryptoNote {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
 
     m_config_folder = config_folder;
-    std::string state_file_path = config_folder + "/" + m_currency.txPoolFileName();
-    boost::system::error_code ec;
-    if (!boost::filesystem::exists(state_file_path, ec)) {
+    if (config_folder.empty()) {
+      // without a folder the pool is kept in memory only
+      m_logFilePath.clear();
       return true;
     }
 
-    if (!loadFromBinaryFile(*this, state_file_path)) {
-      logger(ERROR) << "Failed to load memory pool from file " << state_file_path;
+    m_logFilePath = config_folder + "/" + m_currency.txPoolLogFileName();
+    if (!Tools::create_directories_if_necessary(m_config_folder)) {
+      logger(ERROR) << "Failed to create data directory: " << m_config_folder;
+      return false;
+    }
 
-      m_transactions.clear();
-      m_spent_key_images.clear();
-      m_spentOutputs.clear();
+    std::string state_file_path = config_folder + "/" + m_currency.txPoolFileName();
 
-      m_paymentIdIndex.clear();
-      m_timestampIndex.clear();
-    } else {
-      buildIndices();
+    bool needsCompaction = false;
+    bool legacyStateLoaded = false;
+    boost::system::error_code ec;
+    if (boost::filesystem::exists(m_logFilePath, ec)) {
+      if (!loadFromLog(m_logFilePath, needsCompaction)) {
+        logger(ERROR) << "Failed to load memory pool from file " << m_logFilePath;
+        needsCompaction = true;
+      }
+    } else if (boost::filesystem::exists(state_file_path, ec)) {
+      // pool state written by older versions, it is converted to the journal below
+      if (!loadFromBinaryFile(*this, state_file_path)) {
+        logger(ERROR) << "Failed to load memory pool from file " << state_file_path;
+
+        m_transactions.clear();
+        m_spent_key_images.clear();
+        m_spentOutputs.clear();
+        m_recentlyDeletedTransactions.clear();
+
+        m_paymentIdIndex.clear();
+        m_timestampIndex.clear();
+        m_memoryUsage = 0;
+      } else {
+        buildIndices();
+      }
+
+      needsCompaction = true;
+      legacyStateLoaded = true;
+    }
+
+    if (needsCompaction) {
+      if (!compactLog()) {
+        logger(ERROR) << "Failed to write memory pool journal " << m_logFilePath;
+        return false;
+      }
+
+      if (legacyStateLoaded) {
+        boost::filesystem::remove(state_file_path, ec);
+      }
+    } else if (!m_log.open(m_logFilePath)) {
+      logger(ERROR) << "Failed to open memory pool journal " << m_logFilePath;
+      return false;
     }
 
     removeExpiredTransactions();
+    evictLowFeeTransactions();
 
-    // Ignore deserialization error
+    // damaged pool state is ignored, only a journal that cannot be written fails the initialization
     return true;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::deinit() {
-    if (!Tools::create_directories_if_necessary(m_config_folder)) {
-      logger(INFO) << "Failed to create data directory: " << m_config_folder;
+    // the journal is kept up to date on every change, so there is nothing to write out here
+    m_log.close();
+
+    m_paymentIdIndex.clear();
+    m_timestampIndex.clear();
+    
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::loadFromLog(const std::string& path, bool& needsCompaction) {
+    std::vector<TransactionPoolLog::AddRecord> records;
+    TransactionPoolLog::RemovedTransactions removed;
+    if (!m_log.load(path, records, removed, needsCompaction)) {
       return false;
     }
 
-    std::string state_file_path = m_config_folder + "/" + m_currency.txPoolFileName();
+    // decoding the transactions is the most expensive part of the load, spread it over all cores
+    std::vector<Transaction> transactions(records.size());
+    std::vector<uint8_t> decoded(records.size(), 0);
+    size_t workers = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), records.size() / 64 + 1));
+    std::vector<std::future<void>> decodingThreads;
+    for (size_t worker = 0; worker < workers; ++worker) {
+      decodingThreads.push_back(std::async(std::launch::async, [&records, &transactions, &decoded, workers, worker] {
+        for (size_t i = worker; i < records.size(); i += workers) {
+          decoded[i] = fromBinaryArray(transactions[i], records[i].txBlob) ? 1 : 0;
+        }
+      }));
+    }
 
-    if (!storeToBinaryFile(*this, state_file_path)) {
-      logger(INFO) << "Failed to serialize memory pool to file " << state_file_path;
+    for (auto& thread : decodingThreads) {
+      thread.get();
     }
 
-    m_paymentIdIndex.clear();
-    m_timestampIndex.clear();
-    
+    m_transactions.clear();
+    for (size_t i = 0; i < records.size(); ++i) {
+      const auto& record = records[i];
+      if (!decoded[i]) {
+        logger(WARNING) << "Failed to decode transaction " << record.id << " from memory pool journal, dropped";
+        needsCompaction = true;
+        continue;
+      }
+
+      PoolTransactionDetails txd;
+      txd.id = record.id;
+      txd.blobSize = record.blobSize;
+      txd.fee = record.fee;
+      txd.keptByBlock = record.keptByBlock;
+      txd.receiveTime = static_cast<time_t>(record.receiveTime);
+      txd.maxUsedBlock = record.maxUsedBlock;
+      txd.lastFailedBlock = record.lastFailedBlock;
+      txd.tx = std::move(transactions[i]);
+
+      auto inserted = m_transactions.insert(std::move(txd));
+      if (!inserted.second) {
+        needsCompaction = true;
+        continue;
+      }
+
+      if (!addTransactionInputs(inserted.first->id, inserted.first->tx, inserted.first->keptByBlock)) {
+        logger(WARNING) << "Transaction " << record.id << " from memory pool journal conflicts with another pool transaction, dropped";
+        removeTransactionInputs(inserted.first->id, inserted.first->tx, inserted.first->keptByBlock);
+        m_transactions.erase(inserted.first);
+        needsCompaction = true;
+      }
+    }
+
+    m_recentlyDeletedTransactions.clear();
+    m_recentlyDeletedTransactions.insert(removed.begin(), removed.end());
+
+    buildIndices();
+
+    logger(INFO) << "Loaded " << m_transactions.size() << " transaction(s) from memory pool journal";
     return true;
   }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::compactLog() {
+    std::vector<TransactionPoolLog::AddRecord> records;
+    records.reserve(m_transactions.size());
+    for (const auto& txd : m_transactions) {
+      TransactionPoolLog::AddRecord record;
+      record.id = txd.id;
+      record.blobSize = txd.blobSize;
+      record.fee = txd.fee;
+      record.keptByBlock = txd.keptByBlock;
+      record.receiveTime = static_cast<uint64_t>(txd.receiveTime);
+      record.maxUsedBlock = txd.maxUsedBlock;
+      record.lastFailedBlock = txd.lastFailedBlock;
+      record.txBlob = toBinaryArray(txd.tx);
+      records.push_back(std::move(record));
+    }
+
+    TransactionPoolLog::RemovedTransactions removed(m_recentlyDeletedTransactions.begin(), m_recentlyDeletedTransactions.end());
+    return m_log.compact(m_logFilePath, records, removed);
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::compactLogIfNeeded() {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    if (!m_log.isOpen() || m_log.recordCount() <= 2 * (m_transactions.size() + m_recentlyDeletedTransactions.size()) + 1000) {
+      return true;
+    }
+
+    logger(DEBUGGING) << "Compacting memory pool journal, " << m_log.recordCount() << " records";
+    return compactLog();
+  }
 
 #define CURRENT_MEMPOOL_ARCHIVE_VER 1
 
@@ -600,7 +813,9 @@ namespace CryptoNote {
 
   //---------------------------------------------------------------------------------
   void tx_memory_pool::on_idle() {
-    m_txCheckInterval.call([this](){ return removeExpiredTransactions(); });
+    m_txCheckInterval.call([this](){ return removeExpiredTransactions() && compactLogIfNeeded(); });
+    // the journal is written here rather than on every change, outside of the pool lock
+    m_log.flush();
   }
 
   //---------------------------------------------------------------------------------
@@ -642,8 +857,64 @@ namespace CryptoNote {
     return true;
   }
 
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::isAdmissibleBySize(uint64_t fee, uint64_t blobSize, uint64_t memoryUsage) const {
+    if (m_memoryUsage + memoryUsage <= m_maxSize) {
+      return true;
+    }
+
+    if (memoryUsage > m_maxSize) {
+      return false;
+    }
+
+    if (m_fee_index.empty()) {
+      return true;
+    }
+
+    // the pool is full, a newcomer has to pay more per byte than the cheapest transaction in it
+    const auto& lowest = *m_fee_index.rbegin();
+    uint64_t lhs_hi, lhs_lo = mul128(fee, lowest.blobSize, &lhs_hi);
+    uint64_t rhs_hi, rhs_lo = mul128(lowest.fee, blobSize, &rhs_hi);
+
+    return (lhs_hi > rhs_hi) || (lhs_hi == rhs_hi && lhs_lo > rhs_lo);
+  }
+
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::evictLowFeeTransactions() {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+
+    size_t evicted = 0;
+    auto it = m_fee_index.end();
+    while (m_memoryUsage > m_maxSize && it != m_fee_index.begin()) {
+      auto victim = std::prev(it);
+      if (victim->keptByBlock) {
+        it = victim;
+        continue;
+      }
+
+      logger(DEBUGGING) << "Evicting transaction " << victim->id << " from memory pool, fee " <<
+        m_currency.formatAmount(victim->fee) << ", size " << victim->blobSize;
+      // peers would relay it straight back otherwise
+      m_recentlyDeletedTransactions.emplace(victim->id, m_timeProvider.now());
+      removeTransaction(m_transactions.project<0>(victim));
+      ++evicted;
+    }
+
+    if (evicted != 0) {
+      logger(INFO) << "Memory pool is full, evicted " << evicted << " transaction(s) with the lowest fee per byte. Pool memory usage: " <<
+        m_memoryUsage << " of " << m_maxSize << " bytes";
+    }
+
+    return evicted != 0;
+  }
+
   tx_memory_pool::tx_container_t::iterator tx_memory_pool::removeTransaction(tx_memory_pool::tx_container_t::iterator i) {
     removeTransactionInputs(i->id, i->tx, i->keptByBlock);
+    m_memoryUsage -= std::min(m_memoryUsage, getTransactionMemoryUsage(i->tx, i->blobSize));
+    if (m_log.isOpen()) {
+      auto deleted = m_recentlyDeletedTransactions.find(i->id);
+      m_log.appendRemove(i->id, deleted != m_recentlyDeletedTransactions.end() ? deleted->second : 0);
+    }
     m_paymentIdIndex.remove(i->tx);
     m_timestampIndex.remove(i->receiveTime, i->id);
     if (m_validated_transactions.find(i->id) != m_validated_transactions.end()) {
@@ -747,10 +1018,21 @@ namespace CryptoNote {
 
   void tx_memory_pool::buildIndices() {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+
+    // payment id index needs the transaction extra parsed, build it alongside the cheap ones
+    auto paymentIdIndexing = std::async(std::launch::async, [this] {
+      for (auto it = m_transactions.begin(); it != m_transactions.end(); it++) {
+        m_paymentIdIndex.add(it->tx);
+      }
+    });
+
+    m_memoryUsage = 0;
     for (auto it = m_transactions.begin(); it != m_transactions.end(); it++) {
-      m_paymentIdIndex.add(it->tx);
       m_timestampIndex.add(it->receiveTime, it->id);
+      m_memoryUsage += getTransactionMemoryUsage(it->tx, it->blobSize);
     }
+
+    paymentIdIndexing.get();
   }
 
   bool tx_memory_pool::getTransactionIdsByPaymentId(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionIds) {
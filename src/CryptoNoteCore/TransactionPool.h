@@ -44,6 +44,7 @@
 #include "CryptoNoteCore/VerificationContext.h"
 #include "CryptoNoteCore/BlockchainIndices.h"
 #include "CryptoNoteCore/ICore.h"
+#include "CryptoNoteCore/TransactionPoolLog.h"
 
 #include <Logging/LoggerRef.h>
 
@@ -101,7 +102,8 @@ namespace CryptoNote {
     bool deinit();
 
     bool have_tx(const Crypto::Hash &id) const;
-    bool add_tx(const Transaction &tx, const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keeped_by_block, uint32_t height);
+    // |txBlob|, when the caller has it, is written to the journal instead of serializing |tx| again
+    bool add_tx(const Transaction &tx, const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keeped_by_block, uint32_t height, const BinaryArray* txBlob = nullptr);
     bool add_tx(const Transaction &tx, tx_verification_context& tvc, bool keeped_by_block, uint32_t height);
     //gets tx and remove it from pool
     bool take_tx(const Crypto::Hash &id, Transaction &tx, size_t& blobSize, uint64_t& fee);
@@ -118,6 +120,9 @@ namespace CryptoNote {
     void get_transactions(std::list<Transaction>& txs) const;
     void get_difference(const std::vector<Crypto::Hash>& known_tx_ids, std::vector<Crypto::Hash>& new_tx_ids, std::vector<Crypto::Hash>& deleted_tx_ids) const;
     size_t get_transactions_count() const;
+    uint64_t getMemoryUsage() const;
+    uint64_t getMaxSize() const;
+    void setMaxSize(uint64_t maxSize);
     std::string print_pool(bool short_format) const;
 	
     void on_idle();
@@ -201,9 +206,14 @@ namespace CryptoNote {
 
     tx_container_t::iterator removeTransaction(tx_container_t::iterator i);
     bool removeExpiredTransactions();
+    bool isAdmissibleBySize(uint64_t fee, uint64_t blobSize, uint64_t memoryUsage) const;
+    bool evictLowFeeTransactions();
     bool is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const;
 
     void buildIndices();
+    bool loadFromLog(const std::string& path, bool& needsCompaction);
+    bool compactLog();
+    bool compactLogIfNeeded();
 
     Tools::ObserverManager<ITxPoolObserver> m_observerManager;
     const CryptoNote::Currency& m_currency;
@@ -214,11 +224,15 @@ namespace CryptoNote {
     GlobalOutputsContainer m_spentOutputs;
 
     std::string m_config_folder;
+    std::string m_logFilePath;
+    TransactionPoolLog m_log;
     CryptoNote::ITransactionValidator& m_validator;
     CryptoNote::ITimeProvider& m_timeProvider;
 
     tx_container_t m_transactions;  
     tx_container_t::nth_index<1>::type& m_fee_index;
+    uint64_t m_memoryUsage;
+    uint64_t m_maxSize;
     std::unordered_map<Crypto::Hash, uint64_t> m_recentlyDeletedTransactions;
 
     Logging::LoggerRef logger;
@@ -0,0 +1,392 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TransactionPoolLog.h"
+
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+
+#include "Common/MemoryInputStream.h"
+#include "Common/VectorOutputStream.h"
+#include "crypto/hash.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+
+using namespace Logging;
+
+#undef ERROR
+
+namespace CryptoNote {
+
+namespace {
+
+const char POOL_LOG_MAGIC[] = "FEDGPLOG";
+const size_t POOL_LOG_MAGIC_SIZE = sizeof(POOL_LOG_MAGIC) - 1;
+const uint8_t POOL_LOG_VERSION = 1;
+const size_t RECORD_HEADER_SIZE = 1 + 4 + 4;
+const uint32_t MAX_RECORD_SIZE = 64 * 1024 * 1024;
+
+uint32_t payloadChecksum(const uint8_t* data, size_t size) {
+  Crypto::Hash hash = Crypto::cn_fast_hash(data, size);
+  uint32_t checksum;
+  memcpy(&checksum, hash.data, sizeof(checksum));
+  return checksum;
+}
+
+void writeUint32(uint8_t* dest, uint32_t value) {
+  for (size_t i = 0; i < 4; ++i) {
+    dest[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint32_t readUint32(const uint8_t* src) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(src[i]) << (8 * i);
+  }
+  return value;
+}
+
+}
+
+void TransactionPoolLog::AddRecordHeader::serialize(ISerializer& s) {
+  s(id, "id");
+  s(blobSize, "blobSize");
+  s(fee, "fee");
+  s(keptByBlock, "keptByBlock");
+  s(receiveTime, "receiveTime");
+  s(maxUsedBlock.height, "maxUsedBlock.height");
+  s(maxUsedBlock.id, "maxUsedBlock.id");
+  s(lastFailedBlock.height, "lastFailedBlock.height");
+  s(lastFailedBlock.id, "lastFailedBlock.id");
+}
+
+TransactionPoolLog::TransactionPoolLog(Logging::ILogger& log) : logger(log, "txpool"), m_isOpen(false), m_recordCount(0) {
+}
+
+TransactionPoolLog::~TransactionPoolLog() {
+  close();
+}
+
+bool TransactionPoolLog::load(const std::string& path, std::vector<AddRecord>& added, RemovedTransactions& removed, bool& needsCompaction) {
+  added.clear();
+  removed.clear();
+  needsCompaction = false;
+
+  std::ifstream file(path, std::ios_base::binary | std::ios_base::in);
+  if (file.fail()) {
+    return false;
+  }
+
+  // read the whole journal at once, records are then decoded in place
+  BinaryArray data;
+  file.seekg(0, std::ios_base::end);
+  std::streamoff fileSize = file.tellg();
+  file.seekg(0, std::ios_base::beg);
+  if (fileSize < 0) {
+    return false;
+  }
+
+  data.resize(static_cast<size_t>(fileSize));
+  if (!data.empty() && !file.read(reinterpret_cast<char*>(data.data()), data.size())) {
+    return false;
+  }
+
+  if (data.size() < POOL_LOG_MAGIC_SIZE + 1 || memcmp(data.data(), POOL_LOG_MAGIC, POOL_LOG_MAGIC_SIZE) != 0) {
+    logger(ERROR) << "Memory pool journal " << path << " has unknown format";
+    return false;
+  }
+
+  if (data[POOL_LOG_MAGIC_SIZE] != POOL_LOG_VERSION) {
+    logger(ERROR) << "Memory pool journal " << path << " has unsupported version " << static_cast<unsigned>(data[POOL_LOG_MAGIC_SIZE]);
+    return false;
+  }
+
+  std::unordered_map<Crypto::Hash, size_t> liveRecords;
+  size_t offset = POOL_LOG_MAGIC_SIZE + 1;
+  size_t recordCount = 0;
+
+  while (offset < data.size()) {
+    if (data.size() - offset < RECORD_HEADER_SIZE) {
+      logger(WARNING) << "Memory pool journal has a truncated record at offset " << offset << ", the rest is dropped";
+      needsCompaction = true;
+      break;
+    }
+
+    uint8_t type = data[offset];
+    uint32_t size = readUint32(&data[offset + 1]);
+    uint32_t checksum = readUint32(&data[offset + 5]);
+    const uint8_t* payload = &data[offset + RECORD_HEADER_SIZE];
+
+    if (size > MAX_RECORD_SIZE || data.size() - offset - RECORD_HEADER_SIZE < size || payloadChecksum(payload, size) != checksum) {
+      logger(WARNING) << "Memory pool journal has a damaged record at offset " << offset << ", the rest is dropped";
+      needsCompaction = true;
+      break;
+    }
+
+    try {
+      Common::MemoryInputStream stream(payload, size);
+      BinaryInputStreamSerializer s(stream);
+
+      if (type == RECORD_ADD) {
+        AddRecord record;
+        record.serialize(s);
+        const uint8_t* blob = payload + stream.getPosition();
+        record.txBlob.assign(blob, payload + size);
+
+        removed.erase(record.id);
+
+        auto it = liveRecords.find(record.id);
+        if (it != liveRecords.end()) {
+          added[it->second] = std::move(record);
+        } else {
+          liveRecords.emplace(record.id, added.size());
+          added.push_back(std::move(record));
+        }
+      } else if (type == RECORD_REMOVE) {
+        Crypto::Hash id;
+        uint64_t deletionTime;
+        s(id, "id");
+        s(deletionTime, "deletionTime");
+
+        auto it = liveRecords.find(id);
+        if (it != liveRecords.end()) {
+          // keep |added| dense: move the last record into the freed slot
+          size_t index = it->second;
+          liveRecords.erase(it);
+          if (index != added.size() - 1) {
+            added[index] = std::move(added.back());
+            liveRecords[added[index].id] = index;
+          }
+          added.pop_back();
+        }
+
+        if (deletionTime != 0) {
+          removed[id] = deletionTime;
+        }
+      } else {
+        logger(WARNING) << "Memory pool journal has a record of unknown type " << static_cast<unsigned>(type) << ", skipped";
+      }
+    } catch (std::exception& e) {
+      logger(WARNING) << "Memory pool journal has a malformed record at offset " << offset << ": " << e.what() << ", the rest is dropped";
+      needsCompaction = true;
+      break;
+    }
+
+    offset += RECORD_HEADER_SIZE + size;
+    ++recordCount;
+  }
+
+  if (recordCount > 2 * (added.size() + removed.size()) + 1000) {
+    needsCompaction = true;
+  }
+
+  std::lock_guard<std::mutex> lock(m_pendingMutex);
+  m_recordCount = recordCount;
+  return true;
+}
+
+bool TransactionPoolLog::compact(const std::string& path, const std::vector<AddRecord>& added, const RemovedTransactions& removed) {
+  {
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_pending.clear();
+  }
+
+  std::lock_guard<std::mutex> lock(m_fileMutex);
+  closeFile();
+
+  std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream file(tmpPath, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+    if (file.fail() || !writeHeader(file)) {
+      logger(ERROR) << "Failed to create memory pool journal " << tmpPath;
+      return false;
+    }
+
+    BinaryArray buffer;
+    for (const auto& record : added) {
+      writeAddRecord(buffer, record, record.txBlob);
+      file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+      buffer.clear();
+    }
+
+    for (const auto& entry : removed) {
+      writeRemoveRecord(buffer, entry.first, entry.second);
+    }
+
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    file.flush();
+    if (file.fail()) {
+      logger(ERROR) << "Failed to write memory pool journal " << tmpPath;
+      return false;
+    }
+  }
+
+  boost::system::error_code ec;
+  boost::filesystem::rename(tmpPath, path, ec);
+  if (ec) {
+    logger(ERROR) << "Failed to replace memory pool journal " << path << ": " << ec.message();
+    return false;
+  }
+
+  m_file.open(path, std::ios_base::binary | std::ios_base::out | std::ios_base::app);
+  if (m_file.fail()) {
+    logger(ERROR) << "Failed to open memory pool journal " << path;
+    closeFile();
+    return false;
+  }
+
+  m_isOpen = true;
+  std::lock_guard<std::mutex> pendingLock(m_pendingMutex);
+  m_recordCount = added.size() + removed.size();
+  return true;
+}
+
+bool TransactionPoolLog::open(const std::string& path) {
+  close();
+
+  std::lock_guard<std::mutex> lock(m_fileMutex);
+  boost::system::error_code ec;
+  bool exists = boost::filesystem::exists(path, ec);
+
+  m_file.open(path, std::ios_base::binary | std::ios_base::out | std::ios_base::app);
+  if (m_file.fail()) {
+    logger(ERROR) << "Failed to open memory pool journal " << path;
+    closeFile();
+    return false;
+  }
+
+  if (!exists) {
+    if (!writeHeader(m_file) || !m_file.flush()) {
+      logger(ERROR) << "Failed to write memory pool journal " << path;
+      closeFile();
+      return false;
+    }
+
+    std::lock_guard<std::mutex> pendingLock(m_pendingMutex);
+    m_recordCount = 0;
+  }
+
+  m_isOpen = true;
+  return true;
+}
+
+void TransactionPoolLog::close() {
+  flush();
+
+  std::lock_guard<std::mutex> lock(m_fileMutex);
+  closeFile();
+}
+
+void TransactionPoolLog::closeFile() {
+  m_isOpen = false;
+  if (m_file.is_open()) {
+    m_file.close();
+  }
+
+  m_file.clear();
+}
+
+bool TransactionPoolLog::isOpen() const {
+  return m_isOpen;
+}
+
+void TransactionPoolLog::appendAdd(const AddRecordHeader& header, const BinaryArray& txBlob) {
+  std::lock_guard<std::mutex> lock(m_pendingMutex);
+  writeAddRecord(m_pending, header, txBlob);
+  ++m_recordCount;
+}
+
+void TransactionPoolLog::appendRemove(const Crypto::Hash& id, uint64_t deletionTime) {
+  std::lock_guard<std::mutex> lock(m_pendingMutex);
+  writeRemoveRecord(m_pending, id, deletionTime);
+  ++m_recordCount;
+}
+
+bool TransactionPoolLog::flush() {
+  std::lock_guard<std::mutex> lock(m_fileMutex);
+
+  BinaryArray records;
+  {
+    std::lock_guard<std::mutex> pendingLock(m_pendingMutex);
+    records.swap(m_pending);
+  }
+
+  if (records.empty() || !m_file.is_open()) {
+    return m_file.is_open();
+  }
+
+  m_file.write(reinterpret_cast<const char*>(records.data()), records.size());
+  if (!m_file.flush()) {
+    logger(ERROR) << "Failed to append to memory pool journal";
+    closeFile();
+    return false;
+  }
+
+  return true;
+}
+
+size_t TransactionPoolLog::recordCount() const {
+  std::lock_guard<std::mutex> lock(m_pendingMutex);
+  return m_recordCount;
+}
+
+bool TransactionPoolLog::writeHeader(std::ofstream& file) {
+  file.write(POOL_LOG_MAGIC, POOL_LOG_MAGIC_SIZE);
+  file.put(static_cast<char>(POOL_LOG_VERSION));
+  return !file.fail();
+}
+
+template <typename WritePayload>
+void TransactionPoolLog::writeRecord(BinaryArray& buffer, RecordType type, WritePayload writePayload) {
+  // the size and checksum are filled in once the payload is in place
+  size_t headerOffset = buffer.size();
+  buffer.resize(headerOffset + RECORD_HEADER_SIZE);
+  writePayload(buffer);
+
+  size_t payloadOffset = headerOffset + RECORD_HEADER_SIZE;
+  size_t payloadSize = buffer.size() - payloadOffset;
+  buffer[headerOffset] = type;
+  writeUint32(&buffer[headerOffset + 1], static_cast<uint32_t>(payloadSize));
+  writeUint32(&buffer[headerOffset + 5], payloadChecksum(buffer.data() + payloadOffset, payloadSize));
+}
+
+void TransactionPoolLog::writeAddRecord(BinaryArray& buffer, const AddRecordHeader& header, const BinaryArray& txBlob) {
+  writeRecord(buffer, RECORD_ADD, [&header, &txBlob](BinaryArray& payload) {
+    AddRecordHeader fields = header;
+    Common::VectorOutputStream stream(payload);
+    BinaryOutputStreamSerializer s(stream);
+    fields.serialize(s);
+    payload.insert(payload.end(), txBlob.begin(), txBlob.end());
+  });
+}
+
+void TransactionPoolLog::writeRemoveRecord(BinaryArray& buffer, const Crypto::Hash& id, uint64_t deletionTime) {
+  writeRecord(buffer, RECORD_REMOVE, [&id, deletionTime](BinaryArray& payload) {
+    Crypto::Hash recordId = id;
+    uint64_t recordDeletionTime = deletionTime;
+    Common::VectorOutputStream stream(payload);
+    BinaryOutputStreamSerializer s(stream);
+    s(recordId, "id");
+    s(recordDeletionTime, "deletionTime");
+  });
+}
+
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2012-2016, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Karbo.
+//
+// Karbo is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Karbo is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CryptoNote.h"
+#include "crypto/hash.h"
+#include "CryptoNoteCore/ITransactionValidator.h"
+#include "Logging/LoggerRef.h"
+
+namespace CryptoNote {
+
+class ISerializer;
+
+// Append-only journal of the memory pool. Every added transaction is written once
+// as a record holding its raw blob; every removal is a small tombstone record.
+// The journal is rewritten (compacted) when tombstones start to dominate.
+//
+// File layout: magic, version, then records of
+//   [uint8 type][uint32 payload size][uint32 checksum][payload]
+// A record with a bad checksum or a truncated tail ends the replay.
+//
+// Appended records are buffered in memory and written by flush(), which the pool calls
+// from its idle handler outside of its lock, so adding a transaction never waits for the
+// disk. A crash loses the records appended since the last flush.
+class TransactionPoolLog {
+public:
+  struct AddRecordHeader {
+    Crypto::Hash id;
+    uint64_t blobSize;
+    uint64_t fee;
+    bool keptByBlock;
+    uint64_t receiveTime;
+    BlockInfo maxUsedBlock;
+    BlockInfo lastFailedBlock;
+
+    void serialize(ISerializer& s);
+  };
+
+  struct AddRecord : AddRecordHeader {
+    BinaryArray txBlob;
+  };
+
+  // transaction id -> time it was deleted from the pool; zero time means the removal
+  // does not have to be remembered (e.g. the transaction was included in a block)
+  typedef std::unordered_map<Crypto::Hash, uint64_t> RemovedTransactions;
+
+  explicit TransactionPoolLog(Logging::ILogger& logger);
+  ~TransactionPoolLog();
+
+  // Replays the journal at |path|. Returns false if the file exists but cannot be used at all.
+  // |needsCompaction| is set when the file had a damaged tail or mostly consists of tombstones.
+  bool load(const std::string& path, std::vector<AddRecord>& added, RemovedTransactions& removed, bool& needsCompaction);
+  // Rewrites the journal with the given live state and leaves it open for appending.
+  // Records appended before are dropped, |added| and |removed| have to include them.
+  bool compact(const std::string& path, const std::vector<AddRecord>& added, const RemovedTransactions& removed);
+  bool open(const std::string& path);
+  // flushes the buffered records first
+  void close();
+  bool isOpen() const;
+
+  // |txBlob| is the transaction the header describes
+  void appendAdd(const AddRecordHeader& header, const BinaryArray& txBlob);
+  void appendRemove(const Crypto::Hash& id, uint64_t deletionTime);
+  // Writes the buffered records to the file. Returns false and closes the journal if that fails.
+  bool flush();
+
+  size_t recordCount() const;
+
+private:
+  enum RecordType : uint8_t {
+    RECORD_ADD = 1,
+    RECORD_REMOVE = 2
+  };
+
+  static bool writeHeader(std::ofstream& file);
+  // appends a record to |buffer|, the payload is written by |writePayload|
+  template <typename WritePayload>
+  static void writeRecord(BinaryArray& buffer, RecordType type, WritePayload writePayload);
+  static void writeAddRecord(BinaryArray& buffer, const AddRecordHeader& header, const BinaryArray& txBlob);
+  static void writeRemoveRecord(BinaryArray& buffer, const Crypto::Hash& id, uint64_t deletionTime);
+  void closeFile();
+
+  Logging::LoggerRef logger;
+  // guards m_file
+  std::mutex m_fileMutex;
+  std::ofstream m_file;
+  std::atomic<bool> m_isOpen;
+  // guards m_pending and m_recordCount
+  mutable std::mutex m_pendingMutex;
+  BinaryArray m_pending;
+  size_t m_recordCount;
+};
+
+}
@@ -269,6 +269,9 @@ int main(int argc, char* argv[])
       rpcServer.setContactInfo(rpcConfig.contactInfo);
     }
 
+    rpcServer.setWorkerThreads(rpcConfig.threads, rpcConfig.queueSize);
+    rpcServer.setMaxConnections(rpcConfig.maxConnections);
+
     logger(INFO) << "rpcServer.start";
     rpcServer.start(rpcConfig.bindIp, rpcConfig.bindPort);
 
@@ -19,11 +19,54 @@
 #include "HttpParser.h"
 
 #include <algorithm>
+#include <cstdint>
 
 #include "HttpParserErrorCodes.h"
 
 namespace {
 
+const size_t MAX_HEADERS_SIZE = 64 * 1024;
+const size_t MAX_BODY_SIZE = 64 * 1024 * 1024;
+const char CRLF[] = "\r\n";
+const char HEADERS_END[] = "\r\n\r\n";
+
+void throwUnexpectedSymbol() {
+  throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+}
+
+const char* findLineEnd(const char* begin, const char* end) {
+  return std::search(begin, end, CRLF, CRLF + 2);
+}
+
+// Content-Length and chunk sizes come from the peer, anything but plain digits is refused.
+size_t parseLength(const std::string& value, int base) {
+  if (value.empty() || value.size() > 16) {
+    throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::INVALID_LENGTH));
+  }
+
+  uint64_t length = 0;
+  for (char c : value) {
+    int digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (base == 16 && c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (base == 16 && c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::INVALID_LENGTH));
+    }
+
+    length = length * base + digit;
+  }
+
+  if (length > MAX_BODY_SIZE) {
+    throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::BODY_TOO_LARGE));
+  }
+
+  return static_cast<size_t>(length);
+}
+
 void throwIfNotGood(std::istream& stream) {
   if (!stream.good()) {
     if (stream.eof()) {
@@ -42,7 +85,9 @@ HttpResponse::HTTP_STATUS HttpParser::parseResponseStatusFromString(const std::s
   if (status == "200 OK" || status == "200 Ok") return CryptoNote::HttpResponse::STATUS_200;
   else if (status.substr(0, 4) == "401 ") return CryptoNote::HttpResponse::STATUS_401;
   else if (status == "404 Not Found") return CryptoNote::HttpResponse::STATUS_404;
+  else if (status.substr(0, 4) == "413 ") return CryptoNote::HttpResponse::STATUS_413;
   else if (status == "500 Internal Server Error") return CryptoNote::HttpResponse::STATUS_500;
+  else if (status == "503 Service Unavailable") return CryptoNote::HttpResponse::STATUS_503;
   else throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL),
       "Unknown HTTP status code is given");
 
@@ -54,8 +99,7 @@ void HttpParser::receiveRequest(std::istream& stream, HttpRequest& request) {
   readWord(stream, request.method);
   readWord(stream, request.url);
 
-  std::string httpVersion;
-  readWord(stream, httpVersion);
+  readWord(stream, request.version);
 
   readHeaders(stream, request.headers);
 
@@ -66,6 +110,91 @@ void HttpParser::receiveRequest(std::istream& stream, HttpRequest& request) {
   }
 }
 
+size_t HttpParser::parseRequest(const char* data, size_t size, HttpRequest& request) {
+  if (m_requestSize == 0) {
+    // the end of the headers is looked for in the new data only
+    const char* end = data + size;
+    const char* searchBegin = data + (m_scanned > 3 ? m_scanned - 3 : 0);
+    const char* headersEnd = std::search(searchBegin, end, HEADERS_END, HEADERS_END + 4);
+    if (headersEnd == end) {
+      if (size > MAX_HEADERS_SIZE) {
+        resetPendingRequest();
+        throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::HEADERS_TOO_LARGE));
+      }
+
+      m_scanned = size;
+      return 0;
+    }
+
+    try {
+      parseHead(data, headersEnd + 2);
+    } catch (std::exception&) {
+      resetPendingRequest();
+      throw;
+    }
+  }
+
+  if (size < m_requestSize) {
+    return 0;
+  }
+
+  size_t requestSize = m_requestSize;
+  request = std::move(m_pendingRequest);
+  request.body.assign(data + m_headersSize, requestSize - m_headersSize);
+  resetPendingRequest();
+  return requestSize;
+}
+
+// |headersEnd| points past the CRLF of the last header line, right before the empty line.
+void HttpParser::parseHead(const char* data, const char* headersEnd) {
+  HttpRequest& request = m_pendingRequest;
+  const char* lineEnd = findLineEnd(data, headersEnd);
+  const char* methodEnd = std::find(data, lineEnd, ' ');
+  const char* urlEnd = std::find(std::min(methodEnd + 1, lineEnd), lineEnd, ' ');
+  if (methodEnd == lineEnd || urlEnd == lineEnd) {
+    throwUnexpectedSymbol();
+  }
+
+  request.method.assign(data, methodEnd);
+  request.url.assign(methodEnd + 1, urlEnd);
+  request.version.assign(urlEnd + 1, lineEnd);
+
+  for (const char* line = lineEnd + 2; line < headersEnd; line = lineEnd + 2) {
+    lineEnd = findLineEnd(line, headersEnd);
+    const char* colon = std::find(line, lineEnd, ':');
+    if (colon == lineEnd) {
+      throwUnexpectedSymbol();
+    }
+
+    if (colon == line) {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::EMPTY_HEADER));
+    }
+
+    const char* value = colon + 1;
+    while (value < lineEnd && (*value == ' ' || *value == '\t')) {
+      ++value;
+    }
+
+    const char* valueEnd = lineEnd;
+    while (valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+      --valueEnd;
+    }
+
+    std::string name(line, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    request.headers[name].assign(value, valueEnd);
+  }
+
+  m_headersSize = headersEnd + 2 - data;
+  m_requestSize = m_headersSize + getBodyLen(request.headers);
+}
+
+void HttpParser::resetPendingRequest() {
+  m_scanned = 0;
+  m_headersSize = 0;
+  m_requestSize = 0;
+  m_pendingRequest = HttpRequest();
+}
 
 void HttpParser::receiveResponse(std::istream& stream, HttpResponse& response) {
   std::string httpVersion;
@@ -102,15 +231,21 @@ void HttpParser::receiveResponse(std::istream& stream, HttpResponse& response) {
 
   response.addHeader(name, value);
   auto headers = response.getHeaders();
-  size_t length = 0;
-  auto it = headers.find("content-length");
-  if (it != headers.end()) {
-    length = std::stoul(it->second);
-  }
-  
   std::string body;
-  if (length) {
-    readBody(stream, body, length);
+
+  auto encoding = headers.find("transfer-encoding");
+  if (encoding != headers.end() && encoding->second == "chunked") {
+    readChunkedBody(stream, body);
+  } else {
+    size_t length = 0;
+    auto it = headers.find("content-length");
+    if (it != headers.end()) {
+      length = parseLength(it->second, 10);
+    }
+
+    if (length) {
+      readBody(stream, body, length);
+    }
   }
 
   response.setBody(body);
@@ -205,22 +340,52 @@ bool HttpParser::readHeader(std::istream& stream, std::string& name, std::string
 size_t HttpParser::getBodyLen(const HttpRequest::Headers& headers) {
   auto it = headers.find("content-length");
   if (it != headers.end()) {
-    size_t bytes = std::stoul(it->second);
-    return bytes;
+    return parseLength(it->second, 10);
   }
 
   return 0;
 }
 
 void HttpParser::readBody(std::istream& stream, std::string& body, const size_t bodyLen) {
-  size_t read = 0;
+  size_t offset = body.size();
+  body.resize(offset + bodyLen);
+  stream.read(&body[offset], bodyLen);
+
+  throwIfNotGood(stream);
+}
 
-  while (stream.good() && read < bodyLen) {
-    body += stream.get();
-    ++read;
+void HttpParser::readChunkedBody(std::istream& stream, std::string& body) {
+  std::string line;
+  for (;;) {
+    readLine(stream, line);
+    // chunk extensions after ';' are ignored
+    size_t chunkSize = parseLength(line.substr(0, line.find(';')), 16);
+    if (chunkSize == 0) {
+      break;
+    }
+
+    readBody(stream, body, chunkSize);
+    readLine(stream, line);
+    if (!line.empty()) {
+      throwUnexpectedSymbol();
+    }
   }
 
+  // trailer fields are not used, they end with an empty line
+  do {
+    readLine(stream, line);
+  } while (!line.empty());
+}
+
+void HttpParser::readLine(std::istream& stream, std::string& line) {
+  std::getline(stream, line);
   throwIfNotGood(stream);
+
+  if (line.empty() || line.back() != '\r') {
+    throwUnexpectedSymbol();
+  }
+
+  line.pop_back();
 }
 
 }
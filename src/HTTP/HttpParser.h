@@ -29,17 +29,31 @@ namespace CryptoNote {
 //Blocking HttpParser
 class HttpParser {
 public:
-  HttpParser() {};
+  HttpParser() : m_scanned(0), m_headersSize(0), m_requestSize(0) {};
 
   void receiveRequest(std::istream& stream, HttpRequest& request);
+  // Parses a request from the beginning of the buffer. Returns the number of bytes the request takes,
+  // or zero if the buffer does not hold the whole request yet. In that case the next call must pass
+  // the same request again, possibly followed by more data: what was parsed so far is not repeated.
+  size_t parseRequest(const char* data, size_t size, HttpRequest& request);
   void receiveResponse(std::istream& stream, HttpResponse& response);
   static HttpResponse::HTTP_STATUS parseResponseStatusFromString(const std::string& status);
 private:
+  void parseHead(const char* data, const char* headersEnd);
   void readWord(std::istream& stream, std::string& word);
   void readHeaders(std::istream& stream, HttpRequest::Headers &headers);
   bool readHeader(std::istream& stream, std::string& name, std::string& value);
   size_t getBodyLen(const HttpRequest::Headers& headers);
   void readBody(std::istream& stream, std::string& body, const size_t bodyLen);
+  void readChunkedBody(std::istream& stream, std::string& body);
+  void readLine(std::istream& stream, std::string& line);
+  void resetPendingRequest();
+
+  // the request that parseRequest has seen part of
+  size_t m_scanned;
+  size_t m_headersSize;
+  size_t m_requestSize;
+  HttpRequest m_pendingRequest;
 };
 
 } //namespace CryptoNote
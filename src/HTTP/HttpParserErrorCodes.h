@@ -14,7 +14,10 @@ enum HttpParserErrorCodes {
   STREAM_NOT_GOOD = 1,
   END_OF_STREAM,
   UNEXPECTED_SYMBOL,
-  EMPTY_HEADER
+  EMPTY_HEADER,
+  HEADERS_TOO_LARGE,
+  INVALID_LENGTH,
+  BODY_TOO_LARGE
 };
 
 // custom category:
@@ -36,6 +39,9 @@ public:
       case END_OF_STREAM: return "The stream is ended";
       case UNEXPECTED_SYMBOL: return "Unexpected symbol";
       case EMPTY_HEADER: return "The header name is empty";
+      case HEADERS_TOO_LARGE: return "The headers are too large";
+      case INVALID_LENGTH: return "The body or chunk length is invalid";
+      case BODY_TOO_LARGE: return "The body is too large";
       default: return "Unknown error";
     }
   }
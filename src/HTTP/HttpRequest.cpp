@@ -22,6 +22,10 @@ namespace CryptoNote {
     return body;
   }
 
+  const std::string& HttpRequest::getVersion() const {
+    return version;
+  }
+
   void HttpRequest::addHeader(const std::string& name, const std::string& value) {
     headers[name] = value;
   }
@@ -46,6 +50,11 @@ namespace CryptoNote {
       os << "Host: " << "127.0.0.1" << "\r\n";
     }
 
+    // accepting trailers implies accepting chunked responses, the server streams big bodies then
+    if (headers.find("TE") == headers.end()) {
+      os << "TE: trailers\r\n";
+    }
+
     for (auto pair : headers) {
       os << pair.first << ": " << pair.second << "\r\n";
     }
@@ -17,6 +17,7 @@ namespace CryptoNote {
     const std::string& getUrl() const;
     const Headers& getHeaders() const;
     const std::string& getBody() const;
+    const std::string& getVersion() const;
 
     void addHeader(const std::string& name, const std::string& value);
     void setBody(const std::string& b);
@@ -28,6 +29,7 @@ namespace CryptoNote {
     friend class HttpParser;
 
     std::string url;
+    std::string version;
     Headers headers;
     std::string body;
 
@@ -20,6 +20,8 @@
 
 #include <stdexcept>
 
+#include "Common/StringOutputStream.h"
+
 namespace {
 
 const char* getStatusString(CryptoNote::HttpResponse::HTTP_STATUS status) {
@@ -30,8 +32,12 @@ const char* getStatusString(CryptoNote::HttpResponse::HTTP_STATUS status) {
     return "401 Unauthorized";
   case CryptoNote::HttpResponse::STATUS_404:
     return "404 Not Found";
+  case CryptoNote::HttpResponse::STATUS_413:
+    return "413 Payload Too Large";
   case CryptoNote::HttpResponse::STATUS_500:
     return "500 Internal Server Error";
+  case CryptoNote::HttpResponse::STATUS_503:
+    return "503 Service Unavailable";
   default:
     throw std::runtime_error("Unknown HTTP status code is given");
   }
@@ -45,8 +51,12 @@ const char* getErrorBody(CryptoNote::HttpResponse::HTTP_STATUS status) {
     return "Authorization required\n";
   case CryptoNote::HttpResponse::STATUS_404:
     return "Requested url is not found\n";
+  case CryptoNote::HttpResponse::STATUS_413:
+    return "Request body is too large\n";
   case CryptoNote::HttpResponse::STATUS_500:
     return "Internal server error is occurred\n";
+  case CryptoNote::HttpResponse::STATUS_503:
+    return "Server is overloaded, try again later\n";
   default:
     throw std::runtime_error("Error body for given status is not available");
   }
@@ -77,7 +87,12 @@ void HttpResponse::addHeader(const std::string& name, const std::string& value)
 }
 
 void HttpResponse::setBody(const std::string& b) {
-  body = b;
+  setBody(std::string(b));
+}
+
+void HttpResponse::setBody(std::string&& b) {
+  body = std::move(b);
+  bodyWriter = nullptr;
   if (!body.empty()) {
     headers["Content-Length"] = std::to_string(body.size());
   } else {
@@ -85,14 +100,40 @@ void HttpResponse::setBody(const std::string& b) {
   }
 }
 
-std::ostream& HttpResponse::printHttpResponse(std::ostream& os) const {
-  os << "HTTP/1.1 " << getStatusString(status) << "\r\n";
+void HttpResponse::setBodyWriter(BodyWriter writer) {
+  body.clear();
+  headers.erase("Content-Length");
+  bodyWriter = std::move(writer);
+}
+
+std::string HttpResponse::getHead() const {
+  std::string head = "HTTP/1.1 ";
+  head += getStatusString(status);
+  head += "\r\n";
 
-  for (auto pair: headers) {
-    os << pair.first << ": " << pair.second << "\r\n";
+  for (const auto& pair: headers) {
+    head += pair.first;
+    head += ": ";
+    head += pair.second;
+    head += "\r\n";
+  }
+
+  head += "\r\n";
+  return head;
+}
+
+std::ostream& HttpResponse::printHttpResponse(std::ostream& os) const {
+  if (bodyWriter) {
+    // a stream needs the length up front, so the body is produced first
+    HttpResponse response(*this);
+    std::string producedBody;
+    Common::StringOutputStream stream(producedBody);
+    bodyWriter(stream);
+    response.setBody(std::move(producedBody));
+    return response.printHttpResponse(os);
   }
-  os << "\r\n";
 
+  os << getHead();
   if (!body.empty()) {
     os << body;
   }
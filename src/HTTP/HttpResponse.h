@@ -4,10 +4,13 @@
 
 #pragma once
 
+#include <functional>
 #include <ostream>
 #include <string>
 #include <map>
 
+#include "Common/IOutputStream.h"
+
 namespace CryptoNote {
 
   class HttpResponse {
@@ -16,18 +19,30 @@ namespace CryptoNote {
       STATUS_200,
       STATUS_401,
       STATUS_404,
-      STATUS_500
+      STATUS_413,
+      STATUS_500,
+      STATUS_503
     };
 
+    typedef std::function<void(Common::IOutputStream& stream)> BodyWriter;
+
     HttpResponse();
 
     void setStatus(HTTP_STATUS s);
     void addHeader(const std::string& name, const std::string& value);
     void setBody(const std::string& b);
+    void setBody(std::string&& b);
+    // The body is produced by |writer| while the response is being sent, so a big body
+    // does not have to be kept in memory as a whole. The writer may be called twice and
+    // has to produce the same bytes each time.
+    void setBodyWriter(BodyWriter writer);
 
     const std::map<std::string, std::string>& getHeaders() const { return headers; }
     HTTP_STATUS getStatus() const { return status; }
     const std::string& getBody() const { return body; }
+    const BodyWriter& getBodyWriter() const { return bodyWriter; }
+    // the status line and the headers, up to and including the empty line
+    std::string getHead() const;
 
   private:
     friend std::ostream& operator<<(std::ostream& os, const HttpResponse& resp);
@@ -36,6 +51,7 @@ namespace CryptoNote {
     HTTP_STATUS status;
     std::map<std::string, std::string> headers;
     std::string body;
+    BodyWriter bodyWriter;
   };
 
   inline std::ostream& operator<<(std::ostream& os, const HttpResponse& resp) {
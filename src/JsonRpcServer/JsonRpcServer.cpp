@@ -8,7 +8,6 @@
 #include <future>
 #include <system_error>
 #include <memory>
-#include <sstream>
 #include "HTTP/HttpParserErrorCodes.h"
 
 #include <System/TcpConnection.h>
@@ -43,12 +42,11 @@ void JsonRpcServer::processRequest(const CryptoNote::HttpRequest& req, CryptoNot
     logger(Logging::INFO) << "JsonRpcServer::HTTP request came in: \n" << req;
 
     if (req.getUrl() == "/json_rpc") {
-      std::istringstream jsonInputStream(req.getBody());
       Common::JsonValue jsonRpcRequest;
       Common::JsonValue jsonRpcResponse(Common::JsonValue::OBJECT);
 
       try {
-        jsonInputStream >> jsonRpcRequest;
+        jsonRpcRequest = Common::JsonValue::fromString(req.getBody());
       } catch (std::runtime_error&) {
         logger(Logging::DEBUGGING) << "Couldn't parse request: \"" << req.getBody() << "\"";
         makeJsonParsingErrorResponse(jsonRpcResponse);
@@ -61,11 +59,8 @@ void JsonRpcServer::processRequest(const CryptoNote::HttpRequest& req, CryptoNot
 
       //logger(Logging::DEBUGGING) << "back from processJsonRpcRequest";
 
-      std::ostringstream jsonOutputStream;
-      jsonOutputStream << jsonRpcResponse;
-
       resp.setStatus(CryptoNote::HttpResponse::STATUS_200);
-      resp.setBody(jsonOutputStream.str());
+      resp.setBody(jsonRpcResponse.toString());
 
       //logger(Logging::DEBUGGING) << "json request completed";
 
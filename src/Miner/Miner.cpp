@@ -5,6 +5,8 @@
 #include "Miner.h"
 
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include "crypto/crypto.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
@@ -85,32 +87,47 @@ void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threa
 
 void Miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, uint32_t nonceStep) {
   try {
-    Block block = blockTemplate;
-    Crypto::cn_context cryptoContext;
+    // several nonces are hashed at once when the cache holds a scratchpad for each of them
+    size_t ways = Crypto::cn_slow_hash_ways(nonceStep);
+    std::vector<std::unique_ptr<Crypto::cn_context>> cryptoContexts;
+    Crypto::cn_context* contexts[Crypto::CN_SLOW_HASH_MAX_WAYS];
+    Block blocks[Crypto::CN_SLOW_HASH_MAX_WAYS];
+    for (size_t i = 0; i < ways; ++i) {
+      cryptoContexts.emplace_back(new Crypto::cn_context());
+      contexts[i] = cryptoContexts.back().get();
+      blocks[i] = blockTemplate;
+      blocks[i].nonce += static_cast<uint32_t>(i) * nonceStep;
+    }
+
+    m_logger(Logging::DEBUGGING) << "Mining thread hashes " << ways << " nonce(s) at once, scratchpad uses " <<
+      Crypto::cn_context::page_mode_name(contexts[0]->pages());
 
     while (m_state == MiningState::MINING_IN_PROGRESS) {
-      Crypto::Hash hash;
-      uint32_t extrahashID=0;
-      if (!get_block_longhash(cryptoContext, block, hash, extrahashID)) {
+      Crypto::Hash hashes[Crypto::CN_SLOW_HASH_MAX_WAYS];
+      if (!get_block_longhashes(contexts, blocks, hashes, ways)) {
         //error occured
         m_logger(Logging::DEBUGGING) << "calculating long hash error occured";
         m_state = MiningState::MINING_STOPPED;
         return;
       }
 
-      if (check_hash(hash, difficulty)) {
-        m_logger(Logging::INFO) << "Found block for difficulty " << difficulty;
+      for (size_t i = 0; i < ways; ++i) {
+        if (check_hash(hashes[i], difficulty)) {
+          m_logger(Logging::INFO) << "Found block for difficulty " << difficulty;
+
+          if (!setStateBlockFound()) {
+            m_logger(Logging::DEBUGGING) << "block is already found or mining stopped";
+            return;
+          }
 
-        if (!setStateBlockFound()) {
-          m_logger(Logging::DEBUGGING) << "block is already found or mining stopped";
+          m_block = blocks[i];
           return;
         }
-
-        m_block = block;
-        return;
       }
 
-      block.nonce += nonceStep;
+      for (size_t i = 0; i < ways; ++i) {
+        blocks[i].nonce += static_cast<uint32_t>(ways) * nonceStep;
+      }
     }
   } catch (std::exception& e) {
     m_logger(Logging::ERROR) << "Miner got error: " << e.what();
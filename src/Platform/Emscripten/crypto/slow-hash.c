@@ -318,4 +318,16 @@ void cn_slow_hash_f(size_t majorVersion, void * contextData, const void * data,
     cn_slow_hash(majorVersion, data, length, (char *)hash, 0, 1, 0, (uint32_t)CN_PAGE_SIZE, (uint32_t)CN_SCRATCHPAD, CN_ITERATIONS);
 }
 
+/* no interleaved kernel in the portable version, the inputs are hashed one after another */
+void cn_slow_hash_multi_f(size_t majorVersion, void *const * contexts, const void *const * data, size_t length, char * hashes, size_t count){
+    size_t i;
+    for (i = 0; i < count; i++) {
+        cn_slow_hash(majorVersion, data[i], length, hashes + i * HASH_SIZE, 0, 1, 0, (uint32_t)CN_PAGE_SIZE, (uint32_t)CN_SCRATCHPAD, CN_ITERATIONS);
+    }
+}
+
+bool cn_slow_hash_select_aesni(bool aesni) {
+  return false;
+}
+
 #endif
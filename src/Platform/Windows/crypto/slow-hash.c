@@ -27,6 +27,12 @@ void cn_slow_hash_f(size_t v, void * a, const void * b, size_t c, void * d, bool
 (*cn_slow_hash_fp)(v, a, b, c, d, e);
 }
 
+void (*cn_slow_hash_multi_fp)(size_t, void *const *, const void *const *, size_t, char *, size_t);
+
+void cn_slow_hash_multi_f(size_t v, void *const * a, const void *const * b, size_t c, char * d, size_t e){
+(*cn_slow_hash_multi_fp)(v, a, b, c, d, e);
+}
+
 #if defined(__GNUC__)
 #define likely(x) (__builtin_expect(!!(x), 1))
 #define unlikely(x) (__builtin_expect(!!(x), 0))
@@ -192,7 +198,7 @@ uint32_t extrahashPos(void *ctxdata) {
   return (((struct cn_ctx *)(ctxdata))->state.hs.b[0] & 7);
 }
 
-INITIALIZER(detect_aes) {
+static bool has_aesni(void) {
   int ecx;
 #if defined(_MSC_VER)
   int cpuinfo[4];
@@ -202,5 +208,16 @@ INITIALIZER(detect_aes) {
   int a, b, d;
   __cpuid(1, a, b, ecx, d);
 #endif
-  cn_slow_hash_fp = (ecx & (1 << 25)) ? &cn_slow_hash_aesni : &cn_slow_hash_noaesni;
+  return (ecx & (1 << 25)) != 0;
+}
+
+bool cn_slow_hash_select_aesni(bool aesni) {
+  aesni = aesni && has_aesni();
+  cn_slow_hash_fp = aesni ? &cn_slow_hash_aesni : &cn_slow_hash_noaesni;
+  cn_slow_hash_multi_fp = aesni ? &cn_slow_hash_multi_aesni : &cn_slow_hash_multi_noaesni;
+  return aesni;
+}
+
+INITIALIZER(detect_aes) {
+  cn_slow_hash_select_aesni(true);
 }
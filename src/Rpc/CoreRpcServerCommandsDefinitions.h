@@ -700,6 +700,48 @@ struct COMMAND_RPC_SEND_RAW_TX {
   };
 };
 //-----------------------------------------------
+struct send_raw_tx_result {
+  std::string hash;
+  std::string status;
+
+  void serialize(ISerializer &s) {
+    KV_MEMBER(hash)
+    KV_MEMBER(status)
+  }
+};
+
+struct COMMAND_RPC_SEND_RAW_TXS {
+  struct request {
+    std::vector<std::string> txs_as_hex;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(txs_as_hex)
+    }
+  };
+
+  struct response {
+    std::vector<send_raw_tx_result> results; //in the order of the request
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(results)
+      KV_MEMBER(status)
+    }
+  };
+};
+
+struct COMMAND_RPC_SEND_RAW_TXS_BIN {
+  struct request {
+    std::vector<std::string> txs; //transactions blobs
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(txs)
+    }
+  };
+
+  typedef COMMAND_RPC_SEND_RAW_TXS::response response;
+};
+//-----------------------------------------------
 struct COMMAND_RPC_START_MINING {
   struct request {
     std::string miner_address;
@@ -19,12 +19,17 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpServer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
 #include <boost/scope_exit.hpp>
 
 #include <Common/Base64.h>
 #include <HTTP/HttpParser.h>
+#include <HTTP/HttpParserErrorCodes.h>
 #include <System/InterruptedException.h>
-#include <System/TcpStream.h>
 #include <System/IpAddress.h>
 
 using namespace Logging;
@@ -36,12 +41,247 @@ namespace {
 		response.addHeader("Content-Type", "text/plain");
 		response.setBody("Authorization required");
 	}
+
+const size_t READ_BUFFER_SIZE = 16 * 1024;
+// smaller pieces are copied into the output buffer, bigger ones are written from where they are
+const size_t COALESCE_LIMIT = 16 * 1024;
+const size_t CHUNK_SIZE = 64 * 1024;
+
+std::string getLowercaseHeader(const CryptoNote::HttpRequest& request, const std::string& name) {
+  auto it = request.getHeaders().find(name);
+  if (it == request.getHeaders().end()) {
+    return std::string();
+  }
+
+  std::string value = it->second;
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  return value;
+}
+
+bool isKeepAlive(const CryptoNote::HttpRequest& request) {
+  std::string connection = getLowercaseHeader(request, "connection");
+  if (request.getVersion() == "HTTP/1.0") {
+    return connection == "keep-alive";
+  }
+
+  return connection != "close";
+}
+
+// Chunked responses are sent only to the clients that accept trailers: that implies the
+// chunked encoding, while older clients of this server understand Content-Length only.
+bool acceptsChunked(const CryptoNote::HttpRequest& request) {
+  return request.getVersion() != "HTTP/1.0" && getLowercaseHeader(request, "te").find("trailers") != std::string::npos;
+}
+
+class ConnectionWriter {
+public:
+  ConnectionWriter(System::TcpConnection& connection, Logging::LoggerRef& logger) : m_connection(connection), m_logger(logger) {
+  }
+
+  // Queued data goes out with the next flush, responses to pipelined requests share writes this way.
+  void queue(const char* data, size_t size) {
+    m_buffer.append(data, size);
+  }
+
+  void queue(const std::string& data) {
+    queue(data.data(), data.size());
+  }
+
+  void write(const char* data, size_t size) {
+    if (m_buffer.size() + size <= COALESCE_LIMIT) {
+      queue(data, size);
+      return;
+    }
+
+    flush();
+    writeAll(data, size);
+  }
+
+  void flush() {
+    writeAll(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+  }
+
+private:
+  void writeAll(const char* data, size_t size) {
+    // a zero sized write would shut the connection down
+    while (size > 0) {
+      size_t transferred = m_connection.write(reinterpret_cast<const uint8_t*>(data), size, m_logger);
+      data += transferred;
+      size -= transferred;
+    }
+  }
+
+  System::TcpConnection& m_connection;
+  Logging::LoggerRef& m_logger;
+  std::string m_buffer;
+};
+
+// Sends the body produced by HttpResponse::BodyWriter. The first CHUNK_SIZE bytes are collected before
+// anything is sent: a body that ends by then goes out with Content-Length. A bigger one is streamed in
+// chunks if the client accepts them. Otherwise only its size is counted, and once it is known the
+// body is produced a second time straight into the connection, so it is never held in memory.
+class BodyWriterStream : public Common::IOutputStream {
+public:
+  BodyWriterStream(ConnectionWriter& writer, CryptoNote::HttpResponse& response, bool chunked) :
+    m_writer(writer), m_response(response), m_chunked(chunked), m_headSent(false), m_counting(false), m_size(0) {
+  }
+
+  virtual uint64_t writeSome(const void* data, uint64_t size) override {
+    if (m_counting) {
+      m_size += size;
+      return size;
+    }
+
+    if (m_buffer.size() + size >= CHUNK_SIZE) {
+      if (!m_chunked) {
+        m_counting = true;
+        m_size = m_buffer.size() + size;
+        std::string().swap(m_buffer);
+        return size;
+      }
+
+      writeBufferedChunk();
+      // a big piece becomes a chunk of its own, written straight from the caller's memory
+      writeChunk(static_cast<const char*>(data), static_cast<size_t>(size));
+      return size;
+    }
+
+    m_buffer.append(static_cast<const char*>(data), static_cast<size_t>(size));
+    return size;
+  }
+
+  virtual void flush() override {
+  }
+
+  void finish() {
+    if (m_headSent) {
+      writeBufferedChunk();
+      m_writer.queue("0\r\n\r\n", 5);
+      return;
+    }
+
+    if (m_counting) {
+      m_response.addHeader("Content-Length", std::to_string(m_size));
+      m_writer.queue(m_response.getHead());
+      m_headSent = true;
+      ConnectionStream body(m_writer);
+      m_response.getBodyWriter()(body);
+      if (body.size() != m_size) {
+        throw std::runtime_error("Response body writer produced a different body on the second pass");
+      }
+
+      return;
+    }
+
+    if (!m_buffer.empty()) {
+      m_response.addHeader("Content-Length", std::to_string(m_buffer.size()));
+    }
+
+    m_writer.queue(m_response.getHead());
+    m_writer.write(m_buffer.data(), m_buffer.size());
+  }
+
+  bool headSent() const {
+    return m_headSent;
+  }
+
+private:
+  class ConnectionStream : public Common::IOutputStream {
+  public:
+    explicit ConnectionStream(ConnectionWriter& writer) : m_writer(writer), m_size(0) {
+    }
+
+    virtual uint64_t writeSome(const void* data, uint64_t size) override {
+      m_writer.write(static_cast<const char*>(data), static_cast<size_t>(size));
+      m_size += size;
+      return size;
+    }
+
+    virtual void flush() override {
+    }
+
+    uint64_t size() const {
+      return m_size;
+    }
+
+  private:
+    ConnectionWriter& m_writer;
+    uint64_t m_size;
+  };
+
+  void writeBufferedChunk() {
+    if (!m_buffer.empty()) {
+      writeChunk(m_buffer.data(), m_buffer.size());
+      m_buffer.clear();
+    }
+  }
+
+  void writeChunk(const char* data, size_t size) {
+    if (!m_headSent) {
+      m_response.addHeader("Transfer-Encoding", "chunked");
+      m_writer.queue(m_response.getHead());
+      m_headSent = true;
+    }
+
+    if (size == 0) {
+      // an empty chunk would end the body
+      return;
+    }
+
+    char chunkHeader[24];
+    int headerSize = snprintf(chunkHeader, sizeof(chunkHeader), "%zx\r\n", size);
+    m_writer.queue(chunkHeader, headerSize);
+    m_writer.write(data, size);
+    m_writer.queue("\r\n", 2);
+  }
+
+  ConnectionWriter& m_writer;
+  CryptoNote::HttpResponse& m_response;
+  const bool m_chunked;
+  bool m_headSent;
+  bool m_counting;
+  uint64_t m_size;
+  std::string m_buffer;
+};
+
+void sendBody(ConnectionWriter& writer, const CryptoNote::HttpResponse& response) {
+  writer.queue(response.getHead());
+  writer.write(response.getBody().data(), response.getBody().size());
+}
+
+void sendResponse(ConnectionWriter& writer, const CryptoNote::HttpRequest& request, CryptoNote::HttpResponse& response) {
+  if (!response.getBodyWriter()) {
+    sendBody(writer, response);
+    return;
+  }
+
+  BodyWriterStream stream(writer, response, acceptsChunked(request));
+  try {
+    response.getBodyWriter()(stream);
+  } catch (std::exception&) {
+    if (stream.headSent()) {
+      // the client sees the chunked body cut short
+      throw;
+    }
+
+    // the writer is dropped, so the error response is a plain one
+    response.setBodyWriter({});
+    response.setStatus(CryptoNote::HttpResponse::STATUS_500);
+    sendBody(writer, response);
+    return;
+  }
+
+  // a failure from here on cuts the connection, the head has been sent already
+  stream.finish();
+}
+
 }
 
 namespace CryptoNote {
 
 HttpServer::HttpServer(System::Dispatcher& dispatcher, Logging::ILogger& log)
-  : m_dispatcher(dispatcher), workingContextGroup(dispatcher), logger(log, "HttpServer") {
+  : m_dispatcher(dispatcher), workingContextGroup(dispatcher), logger(log, "HttpServer"), m_maxConnections(0) {
 
 }
 
@@ -54,6 +294,10 @@ void HttpServer::start(const std::string& address, uint16_t port, const std::str
 		}
 }
 
+void HttpServer::setMaxConnections(size_t maxConnections) {
+  m_maxConnections = maxConnections;
+}
+
 void HttpServer::stop() {
   workingContextGroup.interrupt();
   workingContextGroup.wait();
@@ -79,6 +323,9 @@ void HttpServer::acceptLoop() {
     BOOST_SCOPE_EXIT_ALL(this, &connection) { 
       m_connections.erase(&connection); };
 
+    // connections over the limit get their first request refused instead of piling up
+    bool overloaded = m_maxConnections != 0 && m_connections.size() > m_maxConnections;
+
     //auto addr = connection.getPeerAddressAndPort();
     auto addr = std::pair<System::IpAddress, uint16_t>(static_cast<System::IpAddress>(0),     0);
     try {
@@ -92,45 +339,73 @@ void HttpServer::acceptLoop() {
 
     workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this));
 
-    System::TcpStreambuf streambuf(connection, logger);
-    std::iostream stream(&streambuf);
+    ConnectionWriter writer(connection, logger);
     HttpParser parser;
+    std::vector<uint8_t> readBuffer(READ_BUFFER_SIZE);
+    std::string input;
+    size_t inputOffset = 0;
+    bool keepAlive = true;
 
-    for (;;) {
+    while (keepAlive) {
       HttpRequest req;
-      HttpResponse resp;
-	  resp.addHeader("Access-Control-Allow-Origin", "*");
-	  resp.addHeader("content-type", "application/json");
-	
-      parser.receiveRequest(stream, req);
-      //logger(INFO) << "++++ parser got req.method: " << req.method;
- 
-	if (authenticate(req)) {
-		processRequest(req, resp);
-	}
-	else {
-		logger(WARNING) << "Authorization required " << addr.first.toDottedDecimal() << ":" << addr.second;
-		fillUnauthorizedResponse(resp);
-	}
+      size_t requestSize;
+      try {
+        requestSize = parser.parseRequest(input.data() + inputOffset, input.size() - inputOffset, req);
+      } catch (std::system_error& e) {
+        if (e.code() != make_error_code(error::HttpParserErrorCodes::BODY_TOO_LARGE)) {
+          throw;
+        }
+
+        // the body is not read, so the connection can not be used for further requests
+        logger(DEBUGGING) << "Request body is too large, closing connection from " << addr.first.toDottedDecimal() << ":" << addr.second;
+        HttpResponse resp;
+        resp.setStatus(HttpResponse::STATUS_413);
+        resp.addHeader("Connection", "close");
+        sendBody(writer, resp);
+        break;
+      }
 
-      //logger(DEBUGGING) << "++++ RpcServer: writing response: " << resp;
+      if (requestSize == 0) {
+        // answers to the pipelined requests read so far go out together
+        writer.flush();
+        input.erase(0, inputOffset);
+        inputOffset = 0;
 
-      stream << resp;
-      stream.flush();
+        size_t transferred = connection.read(readBuffer.data(), readBuffer.size(), logger);
+        if (transferred == 0) {
+          break;
+        }
 
-      logger(DEBUGGING) << "response written... peek at stream now...";
+        input.append(reinterpret_cast<const char*>(readBuffer.data()), transferred);
+        continue;
+      }
 
-      try {
-        if (stream.peek() == std::iostream::traits_type::eof()) { break; }
-      } catch (std::iostream::failure& e) {
-        logger(DEBUGGING) << "iostream failed";
-        break;
-      } catch(...) {
-        logger(DEBUGGING) << "peek error!";
-        break;
+      inputOffset += requestSize;
+
+      HttpResponse resp;
+      resp.addHeader("Access-Control-Allow-Origin", "*");
+      resp.addHeader("content-type", "application/json");
+
+      if (overloaded) {
+        logger(DEBUGGING) << "Too many connections, refusing request from " << addr.first.toDottedDecimal() << ":" << addr.second;
+        resp.setStatus(HttpResponse::STATUS_503);
+      } else if (authenticate(req)) {
+        processRequest(req, resp);
+      } else {
+        logger(WARNING) << "Authorization required " << addr.first.toDottedDecimal() << ":" << addr.second;
+        fillUnauthorizedResponse(resp);
+      }
+
+      keepAlive = !overloaded && isKeepAlive(req);
+      if (!keepAlive) {
+        resp.addHeader("Connection", "close");
       }
+
+      sendResponse(writer, req, resp);
     }
 
+    writer.flush();
+
     logger(DEBUGGING) << "Closing connection..";
     logger(DEBUGGING) << ".. from " << addr.first.toDottedDecimal() << ":" << addr.second << " total=" << m_connections.size();
 
@@ -41,6 +41,8 @@ public:
 
   void start(const std::string& address, uint16_t port, const std::string& user = "", const std::string& password = "");
   void stop();
+  // Connections beyond |maxConnections| are answered with 503 and closed, zero means no limit.
+  void setMaxConnections(size_t maxConnections);
 
   virtual void processRequest(const HttpRequest& request, HttpResponse& response) = 0;
   virtual size_t get_connections_count() const;
@@ -60,6 +62,7 @@ private:
   System::TcpListener m_listener;
   std::unordered_set<System::TcpConnection*> m_connections;
   std::string m_credentials;
+  size_t m_maxConnections;
 };
 
 }
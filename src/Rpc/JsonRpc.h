@@ -120,6 +120,7 @@ public:
   JsonRpcResponse() : psResp(Common::JsonValue::OBJECT) {}
 
   void parse(const std::string& responseBody) {
+    resultText.clear();
     try {
       psResp = Common::JsonValue::fromString(responseBody);
     } catch (std::exception&) {
@@ -148,17 +149,29 @@ public:
 
   std::string getBody() {
     psResp.set("jsonrpc", std::string("2.0"));
-    return psResp.toString();
+    std::string body = psResp.toString();
+    if (!resultText.empty()) {
+      // "result" sorts after all the other members
+      body.insert(body.size() - 1, ",\"result\":" + resultText);
+    }
+
+    return body;
   }
 
   template <typename T>
   bool setResult(const T& v) {
-    psResp.set("result", storeToJsonValue(v));
+    // the result is printed right away, it is usually the biggest part of the response
+    psResp.erase("result");
+    resultText = storeToJson(v);
     return true;
   }
 
   template <typename T>
   bool getResult(T& v) const {
+    if (!resultText.empty()) {
+      return loadFromJson(v, resultText);
+    }
+
     if (!psResp.contains("result")) {
       return false;
     }
@@ -169,6 +182,7 @@ public:
 
 private:
   Common::JsonValue psResp;
+  std::string resultText;
 };
 
 void invokeJsonRpcCommand(HttpClient& httpClient, JsonRpcRequest& req, JsonRpcResponse& res, const std::string& user = "", const std::string& password = "");
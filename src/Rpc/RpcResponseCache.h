@@ -0,0 +1,175 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace CryptoNote {
+
+// Memory bounded cache of computed RPC response parts.
+//
+// A value is computed once: callers asking for a key that is being computed wait for
+// that computation instead of starting their own. Cached values are checked by the
+// caller supplied predicate on every lookup and recomputed when it rejects them, this
+// is how values depending on the blockchain tip are invalidated.
+//
+// Value must provide size_t memorySize() const. When the total size of cached values
+// exceeds the limit the least recently used ones are dropped.
+template <typename Key, typename Value>
+class RpcResponseCache {
+public:
+  typedef std::shared_ptr<const Value> ValuePtr;
+
+  explicit RpcResponseCache(size_t maxSize) : m_maxSize(maxSize), m_size(0), m_nextId(0) {
+  }
+
+  RpcResponseCache(const RpcResponseCache&) = delete;
+  RpcResponseCache& operator=(const RpcResponseCache&) = delete;
+
+  // |isValid| is called as bool(const Value&), |compute| as ValuePtr(). A null value
+  // returned by |compute| is handed to the waiting callers but is not cached.
+  template <typename IsValid, typename Compute>
+  ValuePtr get(const Key& key, IsValid isValid, Compute compute) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+      uint64_t id = it->second.id;
+      std::shared_future<ValuePtr> future = it->second.value;
+      m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+
+      lock.unlock();
+      ValuePtr value = future.get();
+      if (value && isValid(*value)) {
+        return value;
+      }
+
+      lock.lock();
+      it = m_entries.find(key);
+      if (it != m_entries.end() && it->second.id != id) {
+        // somebody has already started to recompute it, use that result as it is
+        future = it->second.value;
+        lock.unlock();
+        return future.get();
+      }
+    }
+
+    std::promise<ValuePtr> promise;
+    uint64_t id = startComputation(key, promise.get_future().share());
+    lock.unlock();
+
+    ValuePtr value;
+    try {
+      value = compute();
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+      lock.lock();
+      finishComputation(key, id, nullptr);
+      throw;
+    }
+
+    promise.set_value(value);
+    lock.lock();
+    finishComputation(key, id, value);
+    return value;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+      if (it->second.size != 0) {
+        m_lru.erase(it->second.lruPosition);
+        it = m_entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    m_size = 0;
+  }
+
+  // total size of the cached values in bytes
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+  }
+
+  size_t count() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+  }
+
+private:
+  struct Entry {
+    uint64_t id;
+    std::shared_future<ValuePtr> value;
+    // zero while the value is being computed
+    size_t size;
+    typename std::list<Key>::iterator lruPosition;
+  };
+
+  uint64_t startComputation(const Key& key, std::shared_future<ValuePtr> future) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+      m_lru.push_front(key);
+      it = m_entries.emplace(key, Entry{ 0, future, 0, m_lru.begin() }).first;
+    } else {
+      m_size -= it->second.size;
+      it->second.value = future;
+      it->second.size = 0;
+    }
+
+    it->second.id = ++m_nextId;
+    return it->second.id;
+  }
+
+  void finishComputation(const Key& key, uint64_t id, const ValuePtr& value) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || it->second.id != id) {
+      return;
+    }
+
+    if (!value) {
+      m_lru.erase(it->second.lruPosition);
+      m_entries.erase(it);
+      return;
+    }
+
+    // an empty value still has to differ from an entry being computed
+    it->second.size = value->memorySize() + 1;
+    m_size += it->second.size;
+    evict();
+  }
+
+  void evict() {
+    auto position = m_lru.end();
+    while (m_size > m_maxSize && position != m_lru.begin()) {
+      --position;
+      auto it = m_entries.find(*position);
+      if (it->second.size == 0) {
+        continue;
+      }
+
+      m_size -= it->second.size;
+      m_entries.erase(it);
+      position = m_lru.erase(position);
+    }
+  }
+
+  const size_t m_maxSize;
+  size_t m_size;
+  uint64_t m_nextId;
+  std::unordered_map<Key, Entry> m_entries;
+  // most recently used keys first
+  std::list<Key> m_lru;
+  mutable std::mutex m_mutex;
+};
+
+}
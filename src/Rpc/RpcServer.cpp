@@ -6,7 +6,10 @@
 #include "ITransaction.h"
 #include "CryptoNoteCore/TransactionPrefixImpl.h"
 
+#include <algorithm>
+#include <cstring>
 #include <future>
+#include <limits>
 #include <unordered_map>
 #include <iostream>
 #include <sstream>
@@ -16,6 +19,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/foreach.hpp>
+#include <boost/scope_exit.hpp>
 
 #include "Common/Base58.h"
 
@@ -59,11 +63,57 @@ RpcServer::HandlerFunction binMethod(bool (RpcServer::*handler)(typename Command
     }
 
     bool result = (obj->*handler)(req, res);
-    response.setBody(storeToBinaryKeyValue(res.data()));
+
+    // the encoded response is handed to the connection as it is, without a copy into the body string
+    auto serializer = std::make_shared<KVBinaryOutputStreamSerializer>();
+    serialize(static_cast<typename Command::response&>(res), *serializer);
+    response.setBodyWriter([serializer](Common::IOutputStream& stream) {
+      serializer->dump(stream);
+    });
+
     return result;
   };
 }
 
+// Walks the cache pages covering blocks [startIndex, startIndex + count) and passes every page to
+// |append| with the range of its blocks that was asked for.
+template <typename Page, typename MakePage, typename Append>
+bool forEachCachedPage(RpcResponseCache<uint32_t, Page>& cache, core& c, uint32_t startIndex, uint32_t count, MakePage makePage, Append append) {
+  for (uint32_t index = startIndex; index < startIndex + count;) {
+    uint32_t pageStart = index - index % RPC_CACHE_PAGE_BLOCKS;
+    uint32_t end = std::min(pageStart + RPC_CACHE_PAGE_BLOCKS, startIndex + count);
+
+    auto page = cache.get(pageStart, [&](const Page& cached) {
+      // the id of the last block depends on all the blocks before it, so a reorganization is caught as well
+      uint32_t cachedEnd = pageStart + static_cast<uint32_t>(cached.blocks.size());
+      return cachedEnd >= end && c.getBlockIdByHeight(cachedEnd - 1) == cached.lastBlockId;
+    }, [&] {
+      return makePage(pageStart);
+    });
+
+    if (!page || pageStart + page->blocks.size() < end) {
+      return false;
+    }
+
+    append(*page, index - pageStart, end - pageStart);
+    index = end;
+  }
+
+  return true;
+}
+
+size_t estimateMemorySize(const TransactionPrefixInfo& info) {
+  size_t size = sizeof(info) + info.txPrefix.extra.size() + info.txPrefix.outputs.size() * sizeof(TransactionOutput);
+  for (const auto& input : info.txPrefix.inputs) {
+    size += sizeof(input);
+    if (input.type() == typeid(KeyInput)) {
+      size += boost::get<KeyInput>(input).outputIndexes.size() * sizeof(uint32_t);
+    }
+  }
+
+  return size;
+}
+
 template <typename Command>
 RpcServer::HandlerFunction jsonMethod(bool (RpcServer::*handler)(typename Command::request const&, typename Command::response&)) {
   return [handler](RpcServer* obj, const HttpRequest& request, HttpResponse& response) {
@@ -81,61 +131,83 @@ RpcServer::HandlerFunction jsonMethod(bool (RpcServer::*handler)(typename Comman
   };
 }
 
+// RpcHandler::maxWorkers values
+// Handlers run on the workers touch only what is safe to use from any thread: the core, which
+// takes its own locks, the response caches, m_poolRevision and the observed height of
+// m_protocolQuery, which is read under its mutex. The block explorer builder uses the core only.
+// the handler uses the P2P node, the miner or the request url, none of them is thread safe
+const size_t DISPATCHER_THREAD = 0;
+// the handler may take long, keep workers for the rest of the methods
+const size_t HEAVY_QUERY_WORKERS = 2;
+const size_t ALL_WORKERS = std::numeric_limits<size_t>::max();
+
+// how many times a sync response is rebuilt when the main chain switches while it is assembled
+const size_t RPC_CHAIN_SWITCH_RETRIES = 3;
+
 }
   
 std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction>> RpcServer::s_handlers = {
   
   // binary handlers
-  { "/getblocks.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks_bin), false } },
-  { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), false } },
-  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), false } },
-  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), false } },
-  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false } },
-  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), false } },
-  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), false } },
+  { "/getblocks.bin", { binMethod<COMMAND_RPC_GET_BLOCKS_FAST>(&RpcServer::on_get_blocks_bin), false, ALL_WORKERS } },
+  { "/queryblocks.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS>(&RpcServer::on_query_blocks), false, ALL_WORKERS } },
+  { "/queryblockslite.bin", { binMethod<COMMAND_RPC_QUERY_BLOCKS_LITE>(&RpcServer::on_query_blocks_lite), false, ALL_WORKERS } },
+  { "/get_o_indexes.bin", { binMethod<COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES>(&RpcServer::on_get_indexes), false, ALL_WORKERS } },
+  { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false, ALL_WORKERS } },
+  { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), false, ALL_WORKERS } },
+  { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), false, ALL_WORKERS } },
+  { "/sendrawtransactions.bin", { binMethod<COMMAND_RPC_SEND_RAW_TXS_BIN>(&RpcServer::on_send_raw_txs_bin), false, DISPATCHER_THREAD } },
 
   // http POST: json handlers
-  { "/get_block_details_by_height", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::on_get_block_details_by_height), false } },
-  { "/get_block_details_by_hash", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH>(&RpcServer::on_get_block_details_by_hash), false } },
-  { "/get_blocks_details_by_heights", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS>(&RpcServer::on_get_blocks_details_by_heights), false } },
-  { "/get_blocks_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::on_get_blocks_details_by_hashes), false } },
-  { "/get_transaction_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_DETAILS_BY_HASHES>(&RpcServer::on_get_transaction_details_by_hashes), false } },
-  { "/get_transaction_details_by_hash", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH>(&RpcServer::on_get_transaction_details_by_hash), false } },
-  { "/get_transaction_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID>(&RpcServer::on_get_transaction_hashes_by_paymentid), false } },
+  { "/get_block_details_by_height", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::on_get_block_details_by_height), false, HEAVY_QUERY_WORKERS } },
+  { "/get_block_details_by_hash", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HASH>(&RpcServer::on_get_block_details_by_hash), false, HEAVY_QUERY_WORKERS } },
+  { "/get_blocks_details_by_heights", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS>(&RpcServer::on_get_blocks_details_by_heights), false, HEAVY_QUERY_WORKERS } },
+  { "/get_blocks_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::on_get_blocks_details_by_hashes), false, HEAVY_QUERY_WORKERS } },
+  { "/get_transaction_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS_DETAILS_BY_HASHES>(&RpcServer::on_get_transaction_details_by_hashes), false, HEAVY_QUERY_WORKERS } },
+  { "/get_transaction_details_by_hash", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASH>(&RpcServer::on_get_transaction_details_by_hash), false, HEAVY_QUERY_WORKERS } },
+  { "/get_transaction_hashes_by_payment_id", { jsonMethod<COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID>(&RpcServer::on_get_transaction_hashes_by_paymentid), false, HEAVY_QUERY_WORKERS } },
 
   // http GET: json handlers
-  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), true } },
-  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::on_get_height), true } },
-  { "/iscoreready", { jsonMethod<COMMAND_RPC_GET_ISCOREREADY>(&RpcServer::on_get_iscoreready), true } },                        
-  { "/getblockchainindexes", { jsonMethod<COMMAND_RPC_GET_BLOCK_INDEXES>(&RpcServer::on_get_blockindexes), false } },
+  { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), true, DISPATCHER_THREAD } },
+  { "/getheight", { jsonMethod<COMMAND_RPC_GET_HEIGHT>(&RpcServer::on_get_height), true, ALL_WORKERS } },
+  { "/iscoreready", { jsonMethod<COMMAND_RPC_GET_ISCOREREADY>(&RpcServer::on_get_iscoreready), true, DISPATCHER_THREAD } },
+  { "/getblockchainindexes", { jsonMethod<COMMAND_RPC_GET_BLOCK_INDEXES>(&RpcServer::on_get_blockindexes), false, DISPATCHER_THREAD } },
 
-  { "/start_mining", { jsonMethod<COMMAND_RPC_START_MINING>(&RpcServer::on_start_mining), false } },
-  { "/stop_mining", { jsonMethod<COMMAND_RPC_STOP_MINING>(&RpcServer::on_stop_mining), false } },
-  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true } },
+  { "/start_mining", { jsonMethod<COMMAND_RPC_START_MINING>(&RpcServer::on_start_mining), false, DISPATCHER_THREAD } },
+  { "/stop_mining", { jsonMethod<COMMAND_RPC_STOP_MINING>(&RpcServer::on_stop_mining), false, DISPATCHER_THREAD } },
+  { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true, DISPATCHER_THREAD } },
 
-  { "/gettransaction", { jsonMethod<COMMAND_RPC_GET_TRANSACTION>(&RpcServer::on_get_transaction), false } },
-  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::on_get_transactions), false } },
-  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::on_send_raw_tx), false } },
+  { "/gettransaction", { jsonMethod<COMMAND_RPC_GET_TRANSACTION>(&RpcServer::on_get_transaction), false, ALL_WORKERS } },
+  { "/gettransactions", { jsonMethod<COMMAND_RPC_GET_TRANSACTIONS>(&RpcServer::on_get_transactions), false, DISPATCHER_THREAD } },
+  { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::on_send_raw_tx), false, DISPATCHER_THREAD } },
+  { "/sendrawtransactions", { jsonMethod<COMMAND_RPC_SEND_RAW_TXS>(&RpcServer::on_send_raw_txs), false, DISPATCHER_THREAD } },
 
   // these are replicated in the json request POST section below
-  { "/getblock", { jsonMethod<COMMAND_RPC_GET_BLOCK>(&RpcServer::on_get_block), false } },
-  { "/getblockcount", { jsonMethod<COMMAND_RPC_GETBLOCKCOUNT>(&RpcServer::on_getblockcount), true} },
-  { "/getblockhash", { jsonMethod<COMMAND_RPC_GETBLOCKHASH>(&RpcServer::on_getblockhash), false } },
-  { "/getblocktemplate", { jsonMethod<COMMAND_RPC_GETBLOCKTEMPLATE>(&RpcServer::on_getblocktemplate), false } },
-  { "/getcurrencyid", { jsonMethod<COMMAND_RPC_GET_CURRENCY_ID>(&RpcServer::on_get_currency_id), true } },
-  { "/submitblock", { jsonMethod<COMMAND_RPC_SUBMITBLOCK>(&RpcServer::on_submitblock), false } },
-  { "/getlastblockheader", { jsonMethod<COMMAND_RPC_GET_LAST_BLOCK_HEADER>(&RpcServer::on_get_last_block_header),      false } },
-  { "/getblockheaderbyhash", { jsonMethod<COMMAND_RPC_GET_BLOCK_HEADER_BY_HASH>(&RpcServer::on_get_block_header_by_hash), false } },
-  { "/getblockheaderbyheight", { jsonMethod<COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT>(&RpcServer::on_get_block_header_by_height), false } },
+  { "/getblock", { jsonMethod<COMMAND_RPC_GET_BLOCK>(&RpcServer::on_get_block), false, ALL_WORKERS } },
+  { "/getblockcount", { jsonMethod<COMMAND_RPC_GETBLOCKCOUNT>(&RpcServer::on_getblockcount), true, ALL_WORKERS } },
+  { "/getblockhash", { jsonMethod<COMMAND_RPC_GETBLOCKHASH>(&RpcServer::on_getblockhash), false, ALL_WORKERS } },
+  { "/getblocktemplate", { jsonMethod<COMMAND_RPC_GETBLOCKTEMPLATE>(&RpcServer::on_getblocktemplate), false, ALL_WORKERS } },
+  { "/getcurrencyid", { jsonMethod<COMMAND_RPC_GET_CURRENCY_ID>(&RpcServer::on_get_currency_id), true, ALL_WORKERS } },
+  { "/submitblock", { jsonMethod<COMMAND_RPC_SUBMITBLOCK>(&RpcServer::on_submitblock), false, DISPATCHER_THREAD } },
+  { "/getlastblockheader", { jsonMethod<COMMAND_RPC_GET_LAST_BLOCK_HEADER>(&RpcServer::on_get_last_block_header), false, ALL_WORKERS } },
+  { "/getblockheaderbyhash", { jsonMethod<COMMAND_RPC_GET_BLOCK_HEADER_BY_HASH>(&RpcServer::on_get_block_header_by_hash), false, ALL_WORKERS } },
+  { "/getblockheaderbyheight", { jsonMethod<COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT>(&RpcServer::on_get_block_header_by_height), false, ALL_WORKERS } },
  
   // json rpc
-  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } }
+  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true, DISPATCHER_THREAD } }
 };
 
 RpcServer::RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, core& c, NodeServer& p2p, ICryptoNoteProtocolQuery& protocolQuery) : 
   HttpServer(dispatcher, log), logger(log, "RpcServer"), 
   m_core(c), m_p2p(p2p), blockchainExplorerDataBuilder(c, protocolQuery, logger),
-  m_protocolQuery(protocolQuery) {
+  m_protocolQuery(protocolQuery),
+  m_blocksCache(RPC_BLOCKS_CACHE_MAX_SIZE), m_shortBlocksCache(RPC_SHORT_BLOCKS_CACHE_MAX_SIZE),
+  m_poolChangesCache(RPC_POOL_CHANGES_CACHE_MAX_SIZE), m_poolRevision(0) {
+  m_core.addObserver(this);
+}
+
+RpcServer::~RpcServer() {
+  m_core.removeObserver(this);
 }
 
 void RpcServer::processRequest(const HttpRequest& request, HttpResponse& response) {
@@ -157,7 +229,30 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
     return;
   }
 
-  it->second.handler(this, request, response);
+  if (!runHandler(url, it->second.maxWorkers, [&] { it->second.handler(this, request, response); })) {
+    logger(DEBUGGING) << "Request " << url << " refused, too many requests are being processed";
+    response.setStatus(HttpResponse::STATUS_503);
+  }
+}
+
+void RpcServer::setWorkerThreads(size_t threadCount, size_t maxQueueSize) {
+  m_workers.reset(threadCount != 0 ? new System::WorkerPool(m_dispatcher, threadCount, maxQueueSize) : nullptr);
+}
+
+bool RpcServer::runHandler(const std::string& method, size_t maxWorkers, const std::function<void()>& handler) {
+  if (maxWorkers == DISPATCHER_THREAD || !m_workers) {
+    handler();
+    return true;
+  }
+
+  size_t& running = m_runningRequests[method];
+  if (running >= maxWorkers) {
+    return false;
+  }
+
+  ++running;
+  BOOST_SCOPE_EXIT_ALL(&running) { --running; };
+  return m_workers->run(handler);
 }
 
 std::string RpcServer::getHostnm(const HttpRequest& request) {
@@ -195,21 +290,21 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
 
     static std::unordered_map<std::string, RpcServer::RpcHandler<JsonMemberMethod>> jsonRpcHandlers = {
       // these are replicated in GET section above also
-      { "getblock", { makeMemberMethod(&RpcServer::on_get_block), false } },
-      { "getblockcount", { makeMemberMethod(&RpcServer::on_getblockcount), true } },
-      { "getblockhash", { makeMemberMethod(&RpcServer::on_getblockhash), false } },
-      { "getblocktemplate", { makeMemberMethod(&RpcServer::on_getblocktemplate), false } },
-      { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true } },
-      { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false } },
-      { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), false } },
-      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), false } },
-      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), false } },
+      { "getblock", { makeMemberMethod(&RpcServer::on_get_block), false, ALL_WORKERS } },
+      { "getblockcount", { makeMemberMethod(&RpcServer::on_getblockcount), true, ALL_WORKERS } },
+      { "getblockhash", { makeMemberMethod(&RpcServer::on_getblockhash), false, ALL_WORKERS } },
+      { "getblocktemplate", { makeMemberMethod(&RpcServer::on_getblocktemplate), false, ALL_WORKERS } },
+      { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true, ALL_WORKERS } },
+      { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false, DISPATCHER_THREAD } },
+      { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), false, ALL_WORKERS } },
+      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), false, ALL_WORKERS } },
+      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), false, ALL_WORKERS } },
 
       // only accessed via POST here
-      { "gettransactionspool", { makeMemberMethod(&RpcServer::on_get_transactions_pool_short), false } },
-      { "checktransactionproof", {makeMemberMethod(&RpcServer::on_check_transaction_proof), false } },
-      { "checktransactionkey", {makeMemberMethod(&RpcServer::on_check_transaction_key), false } },
-      { "checktransactionviewkey", {makeMemberMethod(&RpcServer::on_check_transaction_view_key), false } }
+      { "gettransactionspool", { makeMemberMethod(&RpcServer::on_get_transactions_pool_short), false, ALL_WORKERS } },
+      { "checktransactionproof", {makeMemberMethod(&RpcServer::on_check_transaction_proof), false, HEAVY_QUERY_WORKERS } },
+      { "checktransactionkey", {makeMemberMethod(&RpcServer::on_check_transaction_key), false, HEAVY_QUERY_WORKERS } },
+      { "checktransactionviewkey", {makeMemberMethod(&RpcServer::on_check_transaction_view_key), false, HEAVY_QUERY_WORKERS } }
     };
 
     //logger(INFO) << "jsonRequest: " << jsonRequest.getMethod();
@@ -224,7 +319,9 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
     }
 
     lastUrl = getHostnm(request); 
-    it->second.handler(this, jsonRequest, jsonResponse);
+    if (!runHandler(jsonRequest.getMethod(), it->second.maxWorkers, [&] { it->second.handler(this, jsonRequest, jsonResponse); })) {
+      throw JsonRpcError(CORE_RPC_ERROR_CODE_OVERLOADED, "Server is overloaded");
+    }
 
   } catch (const JsonRpcError& err) {
     jsonResponse.setError(err);
@@ -317,29 +414,31 @@ bool RpcServer::on_get_blocks_bin(const COMMAND_RPC_GET_BLOCKS_FAST::request& re
     return false;
   }
 
-  uint32_t totalBlockCount;
-  uint32_t startBlockIndex;
-  std::vector<Crypto::Hash> supplement = m_core.findBlockchainSupplement(req.block_ids, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT, totalBlockCount, startBlockIndex);
-
-  res.current_height = totalBlockCount;
-  res.start_height = startBlockIndex;
+  for (size_t attempt = 0; attempt < RPC_CHAIN_SWITCH_RETRIES; ++attempt) {
+    uint32_t totalBlockCount;
+    uint32_t startBlockIndex;
+    std::vector<Crypto::Hash> supplement = m_core.findBlockchainSupplement(req.block_ids, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT, totalBlockCount, startBlockIndex);
 
-  for (const auto& blockId : supplement) {
-    assert(m_core.have_block(blockId));
-    auto completeBlock = m_core.getBlock(blockId);
-    assert(completeBlock != nullptr);
+    res.current_height = totalBlockCount;
+    res.start_height = startBlockIndex;
+    res.blocks.clear();
 
-    res.blocks.resize(res.blocks.size() + 1);
-    res.blocks.back().block = asString(toBinaryArray(completeBlock->getBlock()));
+    // supplement is a run of main chain blocks, they are served from the cached pages
+    std::vector<Crypto::Hash> blockIds;
+    if (!getCachedBlocks(startBlockIndex, static_cast<uint32_t>(supplement.size()), blockIds, res.blocks)) {
+      res.status = "Failed";
+      return false;
+    }
 
-    res.blocks.back().txs.reserve(completeBlock->getTransactionCount());
-    for (size_t i = 0; i < completeBlock->getTransactionCount(); ++i) {
-      res.blocks.back().txs.push_back(asString(toBinaryArray(completeBlock->getTransaction(i))));
+    // the chain may have switched after the supplement was found
+    if (blockIds == supplement) {
+      res.status = CORE_RPC_STATUS_OK;
+      return true;
     }
   }
 
-  res.status = CORE_RPC_STATUS_OK;
-  return true;
+  res.status = "Failed";
+  return false;
 }
 
 bool RpcServer::on_query_blocks(const COMMAND_RPC_QUERY_BLOCKS::request& req, COMMAND_RPC_QUERY_BLOCKS::response& res) {
@@ -364,7 +463,33 @@ bool RpcServer::on_query_blocks_lite(const COMMAND_RPC_QUERY_BLOCKS_LITE::reques
     uint32_t startHeight;
     uint32_t currentHeight;
     uint32_t fullOffset;
-    if (!m_core.queryBlocksLite(req.blockIds, req.timestamp, startHeight, currentHeight, fullOffset, res.items)) {
+    bool consistent = false;
+    for (size_t attempt = 0; attempt < RPC_CHAIN_SWITCH_RETRIES && !consistent; ++attempt) {
+      std::vector<Crypto::Hash> blockIds;
+      if (!m_core.findBlocksToQuery(req.blockIds, req.timestamp, startHeight, currentHeight, fullOffset, blockIds)) {
+        res.status = "Failed to perform query";
+        return false;
+      }
+
+      res.items.clear();
+      res.items.reserve(blockIds.size());
+      for (const auto& id : blockIds) {
+        res.items.push_back(BlockShortInfo());
+        res.items.back().blockId = id;
+      }
+
+      size_t blocksLeft = std::min(BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT - res.items.size(), BLOCKS_SYNCHRONIZING_DEFAULT_COUNT);
+      blocksLeft = std::min(blocksLeft, static_cast<size_t>(currentHeight - std::min(fullOffset, currentHeight)));
+      if (!getCachedShortBlocks(fullOffset, static_cast<uint32_t>(blocksLeft), req.timestamp, res.items)) {
+        res.status = "Failed to perform query";
+        return false;
+      }
+
+      // the ids and the pages were looked up separately, the chain may have switched in between
+      consistent = isMainChainRun(startHeight, res.items);
+    }
+
+    if (!consistent) {
       res.status = "Failed to perform query";
       return false;
     }
@@ -440,13 +565,156 @@ bool RpcServer::onGetPoolChanges(const COMMAND_RPC_GET_POOL_CHANGES::request& re
 bool RpcServer::onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::request& req, COMMAND_RPC_GET_POOL_CHANGES_LITE::response& rsp) {
 
   try {
+    // wallets in sync ask the same question until the pool or the chain changes, the answers are shared;
+    // the key does not depend on the order of the known transactions
+    std::vector<Crypto::Hash> knownTxsIds(req.knownTxsIds);
+    std::sort(knownTxsIds.begin(), knownTxsIds.end(), [](const Crypto::Hash& a, const Crypto::Hash& b) {
+      return memcmp(a.data, b.data, sizeof(a.data)) < 0;
+    });
+
+    BinaryArray keyData(sizeof(Crypto::Hash) * (knownTxsIds.size() + 1));
+    memcpy(keyData.data(), req.tailBlockId.data, sizeof(Crypto::Hash));
+    if (!knownTxsIds.empty()) {
+      memcpy(keyData.data() + sizeof(Crypto::Hash), knownTxsIds.data(), sizeof(Crypto::Hash) * knownTxsIds.size());
+    }
+
+    auto changes = m_poolChangesCache.get(getBinaryArrayHash(keyData), [this](const PoolChanges& cached) {
+      return cached.poolRevision == m_poolRevision;
+    }, [&] {
+      auto result = std::make_shared<PoolChanges>();
+      result->poolRevision = m_poolRevision;
+      result->isTailBlockActual = m_core.getPoolChangesLite(req.tailBlockId, req.knownTxsIds, result->addedTxs, result->deletedTxsIds);
+      result->size = sizeof(PoolChanges) + result->deletedTxsIds.size() * sizeof(Crypto::Hash);
+      for (const auto& tx : result->addedTxs) {
+        result->size += estimateMemorySize(tx);
+      }
+
+      return std::shared_ptr<const PoolChanges>(std::move(result));
+    });
+
     rsp.status = CORE_RPC_STATUS_OK;
-    rsp.isTailBlockActual = m_core.getPoolChangesLite(req.tailBlockId, req.knownTxsIds, rsp.addedTxs, rsp.deletedTxsIds);
+    rsp.isTailBlockActual = changes->isTailBlockActual;
+    rsp.addedTxs = changes->addedTxs;
+    rsp.deletedTxsIds = changes->deletedTxsIds;
   } catch (...) { logger(Logging::INFO) << "exception in onGetPoolChangesLite()"; }
 
   return true;
 }
 
+void RpcServer::blockchainUpdated() {
+  ++m_poolRevision;
+}
+
+void RpcServer::poolUpdated() {
+  ++m_poolRevision;
+}
+
+bool RpcServer::getCachedBlocks(uint32_t startIndex, uint32_t count, std::vector<Crypto::Hash>& blockIds, std::vector<block_complete_entry>& blocks) {
+  blockIds.reserve(blockIds.size() + count);
+  blocks.reserve(blocks.size() + count);
+  return forEachCachedPage(m_blocksCache, m_core, startIndex, count, [this](uint32_t pageStart) {
+    return makeBlocksPage(pageStart);
+  }, [&](const BlocksPage& page, size_t begin, size_t end) {
+    blockIds.insert(blockIds.end(), page.blockIds.begin() + begin, page.blockIds.begin() + end);
+    blocks.insert(blocks.end(), page.blocks.begin() + begin, page.blocks.begin() + end);
+  });
+}
+
+bool RpcServer::getCachedShortBlocks(uint32_t startIndex, uint32_t count, uint64_t timestamp, std::vector<BlockShortInfo>& blocks) {
+  blocks.reserve(blocks.size() + count);
+  return forEachCachedPage(m_shortBlocksCache, m_core, startIndex, count, [this](uint32_t pageStart) {
+    return makeShortBlocksPage(pageStart);
+  }, [&](const ShortBlocksPage& page, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (page.timestamps[i] >= timestamp) {
+        blocks.push_back(page.blocks[i]);
+      } else {
+        blocks.push_back(BlockShortInfo());
+        blocks.back().blockId = page.blocks[i].blockId;
+      }
+    }
+  });
+}
+
+bool RpcServer::isMainChainRun(uint32_t startIndex, const std::vector<BlockShortInfo>& blocks) {
+  bool result = true;
+  m_core.executeLocked([&] {
+    for (size_t i = 0; i < blocks.size() && result; ++i) {
+      result = m_core.getBlockIdByHeight(startIndex + static_cast<uint32_t>(i)) == blocks[i].blockId;
+    }
+
+    return std::error_code();
+  });
+
+  return result;
+}
+
+std::shared_ptr<RpcServer::BlocksPage> RpcServer::makeBlocksPage(uint32_t pageStart) {
+  std::vector<Blockchain::RawBlock> rawBlocks;
+  if (!m_core.getRawBlocks(pageStart, RPC_CACHE_PAGE_BLOCKS, rawBlocks) || rawBlocks.empty()) {
+    return nullptr;
+  }
+
+  auto page = std::make_shared<BlocksPage>();
+  page->lastBlockId = rawBlocks.back().id;
+  page->size = sizeof(BlocksPage) + rawBlocks.size() * sizeof(Crypto::Hash);
+  page->blockIds.reserve(rawBlocks.size());
+  page->blocks.resize(rawBlocks.size());
+
+  for (size_t i = 0; i < rawBlocks.size(); ++i) {
+    page->blockIds.push_back(rawBlocks[i].id);
+    block_complete_entry& entry = page->blocks[i];
+    entry.block = std::move(rawBlocks[i].block);
+    entry.txs = std::move(rawBlocks[i].transactions);
+
+    page->size += sizeof(entry) + entry.block.size();
+    for (const auto& tx : entry.txs) {
+      page->size += sizeof(tx) + tx.size();
+    }
+  }
+
+  return page;
+}
+
+std::shared_ptr<RpcServer::ShortBlocksPage> RpcServer::makeShortBlocksPage(uint32_t pageStart) {
+  std::vector<Blockchain::RawBlock> rawBlocks;
+  if (!m_core.getRawBlocks(pageStart, RPC_CACHE_PAGE_BLOCKS, rawBlocks) || rawBlocks.empty()) {
+    return nullptr;
+  }
+
+  auto page = std::make_shared<ShortBlocksPage>();
+  page->lastBlockId = rawBlocks.back().id;
+  page->size = sizeof(ShortBlocksPage);
+  page->blocks.resize(rawBlocks.size());
+  page->timestamps.reserve(rawBlocks.size());
+
+  for (size_t i = 0; i < rawBlocks.size(); ++i) {
+    BlockShortInfo& item = page->blocks[i];
+    item.blockId = rawBlocks[i].id;
+    item.block = std::move(rawBlocks[i].block);
+    page->timestamps.push_back(rawBlocks[i].timestamp);
+    page->size += sizeof(item) + sizeof(uint64_t) + item.block.size();
+
+    item.txPrefixes.reserve(rawBlocks[i].transactions.size());
+    for (const auto& txBlob : rawBlocks[i].transactions) {
+      BinaryArray blob = asBinaryArray(txBlob);
+      Transaction tx;
+      if (!fromBinaryArray(tx, blob)) {
+        logger(ERROR) << "Failed to parse a stored transaction of block " << item.blockId;
+        return nullptr;
+      }
+
+      TransactionPrefixInfo info;
+      info.txHash = getBinaryArrayHash(blob);
+      info.txPrefix = std::move(tx);
+      page->size += estimateMemorySize(info);
+      item.txPrefixes.push_back(std::move(info));
+    }
+  }
+
+  return page;
+}
+
 bool RpcServer::on_get_blocks_details_by_heights(const COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::request& req, COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::response& rsp) {
 
   try {
@@ -1213,6 +1481,76 @@ bool RpcServer::on_send_raw_tx(const COMMAND_RPC_SEND_RAW_TX::request& req, COMM
   return true;
 }
 
+bool RpcServer::on_send_raw_txs(const COMMAND_RPC_SEND_RAW_TXS::request& req, COMMAND_RPC_SEND_RAW_TXS::response& res) {
+  if (req.txs_as_hex.size() > COMMAND_RPC_SEND_RAW_TXS_MAX_COUNT) {
+    res.status = "Failed, too many transactions";
+    return true;
+  }
+
+  std::vector<BinaryArray> txBlobs(req.txs_as_hex.size());
+  for (size_t i = 0; i < req.txs_as_hex.size(); ++i) {
+    // a blob that is not valid hex stays empty and is rejected along with other malformed transactions
+    if (!fromHex(req.txs_as_hex[i], txBlobs[i])) {
+      logger(INFO) << "[on_send_raw_txs]: Failed to parse tx from hexbuff: " << req.txs_as_hex[i];
+      txBlobs[i].clear();
+    }
+  }
+
+  sendRawTransactions(txBlobs, res.results);
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+bool RpcServer::on_send_raw_txs_bin(const COMMAND_RPC_SEND_RAW_TXS_BIN::request& req, COMMAND_RPC_SEND_RAW_TXS_BIN::response& res) {
+  if (req.txs.size() > COMMAND_RPC_SEND_RAW_TXS_MAX_COUNT) {
+    res.status = "Failed, too many transactions";
+    return true;
+  }
+
+  std::vector<BinaryArray> txBlobs;
+  txBlobs.reserve(req.txs.size());
+  for (const auto& tx : req.txs) {
+    txBlobs.push_back(asBinaryArray(tx));
+  }
+
+  sendRawTransactions(txBlobs, res.results);
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+void RpcServer::sendRawTransactions(const std::vector<BinaryArray>& txBlobs, std::vector<send_raw_tx_result>& results) {
+  std::vector<tx_verification_context> tvcs;
+  m_core.handle_incoming_txs(txBlobs, tvcs);
+
+  NOTIFY_NEW_TRANSACTIONS::request r;
+  results.resize(txBlobs.size());
+  for (size_t i = 0; i < txBlobs.size(); ++i) {
+    const tx_verification_context& tvc = tvcs[i];
+    send_raw_tx_result& result = results[i];
+    if (!txBlobs[i].empty()) {
+      result.hash = Common::podToHex(Crypto::cn_fast_hash(txBlobs[i].data(), txBlobs[i].size()));
+    }
+
+    if (tvc.m_verifivation_failed) {
+      result.status = "Failed";
+    } else if (!tvc.m_should_be_relayed) {
+      result.status = "Not relayed";
+    } else if (!checkIncomingTransactionForFee(txBlobs[i])) {
+      result.status = "Not relayed due to lack of node fee";
+    } else {
+      r.txs.push_back(asString(txBlobs[i]));
+      result.status = CORE_RPC_STATUS_OK;
+    }
+  }
+
+  logger(DEBUGGING) << "[sendRawTransactions]: " << r.txs.size() << " of " << txBlobs.size() << " transaction(s) relayed";
+
+  // all accepted transactions go to the peers in a single notification
+  if (!r.txs.empty()) {
+    m_core.get_protocol()->relay_transactions(r);
+  }
+}
+
 bool RpcServer::on_start_mining(const COMMAND_RPC_START_MINING::request& req, COMMAND_RPC_START_MINING::response& res) {
   AccountPublicAddress adr;
   if (!m_core.currency().parseAccountAddressString(req.miner_address, adr)) {
@@ -4,29 +4,44 @@
 
 #include "HttpServer.h"
 
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <unordered_map>
 
 #include <Logging/LoggerRef.h>
 #include "CoreRpcServerCommandsDefinitions.h"
+#include "RpcResponseCache.h"
 #include "BlockchainExplorer/BlockchainExplorerDataBuilder.h"
+#include "CryptoNoteCore/ICoreObserver.h"
+#include "System/WorkerPool.h"
 
 const uint32_t MAX_NUMBER_OF_BLOCKS_PER_STATS_REQUEST = 10000;
 const uint64_t BLOCK_LIST_MAX_COUNT = 1000;
 
+// wallet synchronization responses are cached in pages of this many blocks
+const uint32_t RPC_CACHE_PAGE_BLOCKS = 100;
+const size_t RPC_BLOCKS_CACHE_MAX_SIZE = 64 * 1024 * 1024;
+const size_t RPC_SHORT_BLOCKS_CACHE_MAX_SIZE = 32 * 1024 * 1024;
+const size_t RPC_POOL_CHANGES_CACHE_MAX_SIZE = 8 * 1024 * 1024;
+
 namespace CryptoNote {
 
 class core;
 class NodeServer;
 class ICryptoNoteProtocolQuery;
 
-class RpcServer : public HttpServer {
+class RpcServer : public HttpServer, private ICoreObserver {
 public:
   RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, core& c, NodeServer& p2p, ICryptoNoteProtocolQuery& protocolQuery);
+  virtual ~RpcServer();
 
   typedef std::function<bool(RpcServer*, const HttpRequest& request, HttpResponse& response)> HandlerFunction;
 
   bool setContactInfo(const std::string& contact);
+  // Handlers allowed to leave the dispatcher thread run on |threadCount| worker threads, requests
+  // beyond |maxQueueSize| waiting ones are refused. Without workers every handler runs on the dispatcher.
+  void setWorkerThreads(size_t threadCount, size_t maxQueueSize);
 
 private:
 
@@ -38,6 +53,8 @@ private:
   struct RpcHandler {
     const Handler handler;
     const bool allowBusyCore;
+    // how many requests of the method may run on the worker threads at once, zero keeps it on the dispatcher
+    const size_t maxWorkers;
   };
 
   typedef void (RpcServer::*HandlerPtr)(const HttpRequest& request, HttpResponse& response);
@@ -50,7 +67,51 @@ private:
   bool setFeeAddress(const std::string& fee_address, const AccountPublicAddress& fee_acc);
 
   bool isCoreReady();
+  // Runs the handler of |method| where its RpcHandler::maxWorkers says. Returns false if it was refused for overload.
+  bool runHandler(const std::string& method, size_t maxWorkers, const std::function<void()>& handler);
   bool checkIncomingTransactionForFee(const BinaryArray& tx_blob);
+  void sendRawTransactions(const std::vector<BinaryArray>& txBlobs, std::vector<send_raw_tx_result>& results);
+
+  // blocks [start, start + RPC_CACHE_PAGE_BLOCKS) of the main chain as /getblocks.bin sends them;
+  // the page is shorter when it reaches the chain tip
+  struct BlocksPage {
+    Crypto::Hash lastBlockId;
+    std::vector<Crypto::Hash> blockIds;
+    std::vector<block_complete_entry> blocks;
+    size_t size;
+
+    size_t memorySize() const { return size; }
+  };
+
+  // the same for /queryblockslite.bin, the timestamps decide which blocks are sent with contents
+  struct ShortBlocksPage {
+    Crypto::Hash lastBlockId;
+    std::vector<BlockShortInfo> blocks;
+    std::vector<uint64_t> timestamps;
+    size_t size;
+
+    size_t memorySize() const { return size; }
+  };
+
+  struct PoolChanges {
+    uint64_t poolRevision;
+    bool isTailBlockActual;
+    std::vector<TransactionPrefixInfo> addedTxs;
+    std::vector<Crypto::Hash> deletedTxsIds;
+    size_t size;
+
+    size_t memorySize() const { return size; }
+  };
+
+  // ICoreObserver
+  virtual void blockchainUpdated() override;
+  virtual void poolUpdated() override;
+
+  bool getCachedBlocks(uint32_t startIndex, uint32_t count, std::vector<Crypto::Hash>& blockIds, std::vector<block_complete_entry>& blocks);
+  bool getCachedShortBlocks(uint32_t startIndex, uint32_t count, uint64_t timestamp, std::vector<BlockShortInfo>& blocks);
+  bool isMainChainRun(uint32_t startIndex, const std::vector<BlockShortInfo>& blocks);
+  std::shared_ptr<BlocksPage> makeBlocksPage(uint32_t pageStart);
+  std::shared_ptr<ShortBlocksPage> makeShortBlocksPage(uint32_t pageStart);
 
   // binary handlers
   bool on_get_blocks_bin(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res);
@@ -68,6 +129,8 @@ private:
   bool on_get_transaction(const COMMAND_RPC_GET_TRANSACTION::request& req, COMMAND_RPC_GET_TRANSACTION::response& res);
   bool on_get_transactions(const COMMAND_RPC_GET_TRANSACTIONS::request& req, COMMAND_RPC_GET_TRANSACTIONS::response& res);
   bool on_send_raw_tx(const COMMAND_RPC_SEND_RAW_TX::request& req, COMMAND_RPC_SEND_RAW_TX::response& res);
+  bool on_send_raw_txs(const COMMAND_RPC_SEND_RAW_TXS::request& req, COMMAND_RPC_SEND_RAW_TXS::response& res);
+  bool on_send_raw_txs_bin(const COMMAND_RPC_SEND_RAW_TXS_BIN::request& req, COMMAND_RPC_SEND_RAW_TXS_BIN::response& res);
   bool on_start_mining(const COMMAND_RPC_START_MINING::request& req, COMMAND_RPC_START_MINING::response& res);
   bool on_stop_mining(const COMMAND_RPC_STOP_MINING::request& req, COMMAND_RPC_STOP_MINING::response& res);
   bool on_stop_daemon(const COMMAND_RPC_STOP_DAEMON::request& req, COMMAND_RPC_STOP_DAEMON::response& res);
@@ -109,6 +172,17 @@ private:
   BlockchainExplorerDataBuilder blockchainExplorerDataBuilder;
   const ICryptoNoteProtocolQuery& m_protocolQuery;
 
+  RpcResponseCache<uint32_t, BlocksPage> m_blocksCache;
+  RpcResponseCache<uint32_t, ShortBlocksPage> m_shortBlocksCache;
+  // keyed by the hash of the request
+  RpcResponseCache<Crypto::Hash, PoolChanges> m_poolChangesCache;
+  // changes whenever the result of a pool changes request may change
+  std::atomic<uint64_t> m_poolRevision;
+
+  std::unique_ptr<System::WorkerPool> m_workers;
+  // method -> requests running on the workers; used on the dispatcher thread only
+  std::unordered_map<std::string, size_t> m_runningRequests;
+
   //jojapoppa, add later to support VPN charges, see Karbo code
   //std::string m_fee_address;
   //CryptoNote::AccountPublicAddress m_fee_acc;
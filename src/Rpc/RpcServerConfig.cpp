@@ -12,15 +12,24 @@ namespace CryptoNote {
 
     const std::string DEFAULT_RPC_IP = "127.0.0.1";
     const uint16_t DEFAULT_RPC_PORT = RPC_DEFAULT_PORT;
+    const uint32_t DEFAULT_RPC_THREADS = 4;
+    const uint32_t DEFAULT_RPC_QUEUE_SIZE = 256;
+    const uint32_t DEFAULT_RPC_MAX_CONNECTIONS = 1000;
 
     const command_line::arg_descriptor<std::string> arg_rpc_bind_ip = { "rpc-bind-ip", "", DEFAULT_RPC_IP };
     const command_line::arg_descriptor<uint16_t> arg_rpc_bind_port = { "rpc-bind-port", "", DEFAULT_RPC_PORT };
-    const command_line::arg_descriptor<std::string> arg_set_contact = { "contact", "Sets node admin contact", "" }; }
+    const command_line::arg_descriptor<std::string> arg_set_contact = { "contact", "Sets node admin contact", "" };
+    const command_line::arg_descriptor<uint32_t> arg_rpc_threads = { "rpc-threads", "Number of threads serving read-only RPC requests, 0 serves them on the main thread", DEFAULT_RPC_THREADS };
+    const command_line::arg_descriptor<uint32_t> arg_rpc_queue_size = { "rpc-queue-size", "Number of RPC requests waiting for a thread before new ones are refused", DEFAULT_RPC_QUEUE_SIZE };
+    const command_line::arg_descriptor<uint32_t> arg_rpc_max_connections = { "rpc-max-connections", "Maximum number of open RPC connections, 0 for no limit", DEFAULT_RPC_MAX_CONNECTIONS }; }
 
   RpcServerConfig::RpcServerConfig() :
     bindIp(DEFAULT_RPC_IP),
     bindPort(DEFAULT_RPC_PORT),
-    contactInfo("") {
+    contactInfo(""),
+    threads(DEFAULT_RPC_THREADS),
+    queueSize(DEFAULT_RPC_QUEUE_SIZE),
+    maxConnections(DEFAULT_RPC_MAX_CONNECTIONS) {
   }
 
   std::string RpcServerConfig::getBindAddress() const {
@@ -31,12 +40,18 @@ namespace CryptoNote {
     command_line::add_arg(desc, arg_rpc_bind_ip);
     command_line::add_arg(desc, arg_rpc_bind_port);
     command_line::add_arg(desc, arg_set_contact);
+    command_line::add_arg(desc, arg_rpc_threads);
+    command_line::add_arg(desc, arg_rpc_queue_size);
+    command_line::add_arg(desc, arg_rpc_max_connections);
   }
 
   void RpcServerConfig::init(const boost::program_options::variables_map& vm)  {
     bindIp = command_line::get_arg(vm, arg_rpc_bind_ip);
     bindPort = command_line::get_arg(vm, arg_rpc_bind_port);
     contactInfo = command_line::get_arg(vm, arg_set_contact);
+    threads = command_line::get_arg(vm, arg_rpc_threads);
+    queueSize = command_line::get_arg(vm, arg_rpc_queue_size);
+    maxConnections = command_line::get_arg(vm, arg_rpc_max_connections);
   }
 
 }
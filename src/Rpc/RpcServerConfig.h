@@ -21,6 +21,9 @@ public:
   std::string bindIp;
   uint16_t bindPort;
   std::string contactInfo;
+  uint32_t threads;
+  uint32_t queueSize;
+  uint32_t maxConnections;
 };
 
 }
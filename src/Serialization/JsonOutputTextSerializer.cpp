@@ -0,0 +1,141 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "JsonOutputTextSerializer.h"
+#include <cassert>
+#include "Common/JsonValue.h"
+#include "Common/StringTools.h"
+
+using namespace CryptoNote;
+
+JsonOutputTextSerializer::JsonOutputTextSerializer() : text(1, '{') {
+  scopes.push_back({ false, true });
+}
+
+JsonOutputTextSerializer::~JsonOutputTextSerializer() {
+}
+
+ISerializer::SerializerType JsonOutputTextSerializer::type() const {
+  return ISerializer::OUTPUT;
+}
+
+bool JsonOutputTextSerializer::beginObject(Common::StringView name) {
+  beginValue(name);
+  text += '{';
+  scopes.push_back({ false, true });
+  return true;
+}
+
+void JsonOutputTextSerializer::endObject() {
+  assert(scopes.size() > 1 && !scopes.back().array);
+  scopes.pop_back();
+  text += '}';
+}
+
+bool JsonOutputTextSerializer::beginArray(uint64_t& size, Common::StringView name) {
+  beginValue(name);
+  text += '[';
+  scopes.push_back({ true, true });
+  return true;
+}
+
+void JsonOutputTextSerializer::endArray() {
+  assert(scopes.size() > 1 && scopes.back().array);
+  scopes.pop_back();
+  text += ']';
+}
+
+bool JsonOutputTextSerializer::operator()(uint8_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonOutputTextSerializer::operator()(int16_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonOutputTextSerializer::operator()(uint16_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonOutputTextSerializer::operator()(int32_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonOutputTextSerializer::operator()(uint32_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonOutputTextSerializer::operator()(int64_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonOutputTextSerializer::operator()(uint64_t& value, Common::StringView name) {
+  // JsonValue keeps integers signed
+  writeInteger(static_cast<int64_t>(value), name);
+  return true;
+}
+
+bool JsonOutputTextSerializer::operator()(double& value, Common::StringView name) {
+  beginValue(name);
+  Common::appendJsonReal(text, value);
+  return true;
+}
+
+bool JsonOutputTextSerializer::operator()(bool& value, Common::StringView name) {
+  beginValue(name);
+  text += value ? "true" : "false";
+  return true;
+}
+
+bool JsonOutputTextSerializer::operator()(std::string& value, Common::StringView name) {
+  beginValue(name);
+  text += '"';
+  text += value;
+  text += '"';
+  return true;
+}
+
+bool JsonOutputTextSerializer::binary(void* value, uint64_t size, Common::StringView name) {
+  beginValue(name);
+  text += '"';
+  Common::toHex(value, size, text);
+  text += '"';
+  return true;
+}
+
+bool JsonOutputTextSerializer::binary(std::string& value, Common::StringView name) {
+  return binary(const_cast<char*>(value.data()), value.size(), name);
+}
+
+std::string JsonOutputTextSerializer::takeText() {
+  assert(scopes.size() == 1);
+  text += '}';
+  scopes.clear();
+  return std::move(text);
+}
+
+void JsonOutputTextSerializer::beginValue(Common::StringView name) {
+  Scope& scope = scopes.back();
+  if (!scope.empty) {
+    text += ',';
+  }
+
+  scope.empty = false;
+  if (!scope.array) {
+    text += '"';
+    text.append(name.getData(), name.getSize());
+    text += "\":";
+  }
+}
+
+void JsonOutputTextSerializer::writeInteger(int64_t value, Common::StringView name) {
+  beginValue(name);
+  Common::appendJsonInteger(text, value);
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "WorkerPool.h"
+
+#include <exception>
+
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <System/InterruptedException.h>
+
+namespace System {
+
+WorkerPool::WorkerPool(Dispatcher& dispatcher, size_t threadCount, size_t maxQueueSize) :
+  dispatcher(dispatcher), maxQueueSize(maxQueueSize), idleThreads(threadCount), stopped(false) {
+  threads.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back(&WorkerPool::workerThread, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+
+  haveWork.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+bool WorkerPool::run(const std::function<void()>& operation) {
+  Event done(dispatcher);
+  std::exception_ptr error;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.size() >= idleThreads + maxQueueSize) {
+      return false;
+    }
+
+    queue.push_back([&] {
+      try {
+        operation();
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      Event* doneEvent = &done;
+      dispatcher.remoteSpawn([doneEvent] { doneEvent->set(); });
+    });
+  }
+
+  haveWork.notify_one();
+
+  // the operation refers to this frame, so it has to complete even if the context is interrupted
+  bool interrupted = false;
+  while (!done.get()) {
+    try {
+      done.wait();
+    } catch (InterruptedException&) {
+      interrupted = true;
+    }
+  }
+
+  if (interrupted) {
+    dispatcher.interrupt();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  return true;
+}
+
+size_t WorkerPool::threadCount() const {
+  return threads.size();
+}
+
+size_t WorkerPool::queueSize() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return queue.size();
+}
+
+void WorkerPool::workerThread() {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    // operations queued before the stop are still run, their contexts wait for them
+    while (!stopped && queue.empty()) {
+      haveWork.wait(lock);
+    }
+
+    if (queue.empty()) {
+      return;
+    }
+
+    std::function<void()> operation = std::move(queue.front());
+    queue.pop_front();
+    --idleThreads;
+
+    lock.unlock();
+    operation();
+    lock.lock();
+
+    ++idleThreads;
+  }
+}
+
+}
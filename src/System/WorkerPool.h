@@ -0,0 +1,52 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace System {
+
+class Dispatcher;
+
+// Fixed set of threads running operations on behalf of dispatcher contexts. A context that
+// submits an operation is suspended until it completes, the dispatcher runs other contexts
+// meanwhile; unlike RemoteContext no thread is started per operation.
+class WorkerPool {
+public:
+  WorkerPool(Dispatcher& dispatcher, size_t threadCount, size_t maxQueueSize);
+  WorkerPool(const WorkerPool&) = delete;
+  ~WorkerPool();
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Runs |operation| on a worker thread and waits for it, rethrowing its exception. Returns false
+  // without running it if no thread is idle and |maxQueueSize| operations are already waiting for one,
+  // so zero |maxQueueSize| means that operations are only taken by idle threads.
+  // Must be called from a dispatcher context.
+  bool run(const std::function<void()>& operation);
+
+  size_t threadCount() const;
+  size_t queueSize() const;
+
+private:
+  void workerThread();
+
+  Dispatcher& dispatcher;
+  const size_t maxQueueSize;
+  mutable std::mutex mutex;
+  std::condition_variable haveWork;
+  std::deque<std::function<void()>> queue;
+  // threads not running an operation, the ones woken for a queued operation included
+  size_t idleThreads;
+  bool stopped;
+  std::vector<std::thread> threads;
+};
+
+}
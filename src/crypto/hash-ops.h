@@ -52,12 +52,18 @@ void hash_process(union hash_state *state, const uint8_t *buf, size_t count);
 enum {
   HASH_SIZE = 32,
   HASH_DATA_AREA = 136,
-  SLOW_HASH_CONTEXT_SIZE = 2097552
+  SLOW_HASH_CONTEXT_SIZE = 2097552,
+  CN_SLOW_HASH_MAX_WAYS = 4
 };
 
 void cn_fast_hash(const void *data, size_t length, char *hash);
 
 void cn_slow_hash_f(size_t, void *, const void *, size_t, void *, bool);
+// hashes |count| inputs of the same length with one context each, |hashes| receives count * HASH_SIZE bytes
+void cn_slow_hash_multi_f(size_t majorVersion, void *const *contexts, const void *const *data, size_t length, char *hashes, size_t count);
+// the AES-NI kernels are used when |aesni| is set and the CPU supports them, the portable ones otherwise,
+// returns whether AES-NI is used; the best kernels are selected at startup
+bool cn_slow_hash_select_aesni(bool aesni);
 
 void hash_extra_blake(const void *data, size_t length, char *hash);
 void hash_extra_groestl(const void *data, size_t length, char *hash);
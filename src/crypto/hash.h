@@ -32,17 +32,32 @@ namespace Crypto {
   class cn_context {
   public:
 
-    cn_context();
+    // pages backing the scratchpad, huge pages avoid most TLB misses of the random scratchpad accesses
+    enum page_mode {
+      default_pages,
+      transparent_huge_pages,
+      huge_pages
+    };
+
+    // |pages| is the best mode to try, the context falls back to the next modes when it is unavailable
+    explicit cn_context(page_mode pages = huge_pages);
     ~cn_context() noexcept(false);
 #if !defined(_MSC_VER) || _MSC_VER >= 1800
     cn_context(const cn_context &) = delete;
     void operator=(const cn_context &) = delete;
 #endif
 
+    page_mode pages() const { return m_pages; }
+    static const char *page_mode_name(page_mode mode);
+
     void *data;
 
   private:
 
+    void *m_map;
+    size_t m_mapSize;
+    page_mode m_pages;
+
     friend inline void cn_slow_hash(size_t, cn_context &, const void *, size_t, Hash &, bool);
   };
 
@@ -50,6 +65,22 @@ namespace Crypto {
     (*cn_slow_hash_f)(majorVersion, context.data, data, length, reinterpret_cast<void *>(&hash), walletkey);
   }
 
+  // Hashes |count| inputs of the same |length| at once, one context per input. The memory-hard
+  // loops of the inputs are interleaved so that their dependency chains overlap.
+  inline void cn_slow_hash_multi(size_t majorVersion, cn_context *const *contexts, const void *const *data, size_t length, Hash *hashes, size_t count) {
+    const size_t max_ways = CN_SLOW_HASH_MAX_WAYS;
+    const size_t ways = count < max_ways ? count : max_ways;
+    void *states[CN_SLOW_HASH_MAX_WAYS];
+    for (size_t i = 0; i < ways; ++i) {
+      states[i] = contexts[i]->data;
+    }
+    cn_slow_hash_multi_f(majorVersion, states, data, length, reinterpret_cast<char *>(hashes), ways);
+  }
+
+  // Number of inputs (1, 2 or 4) each of |threads| hashing threads should process at once,
+  // so that all scratchpads still fit the last level cache.
+  size_t cn_slow_hash_ways(size_t threads);
+
   inline void tree_hash(const Hash *hashes, size_t count, Hash &root_hash) {
     tree_hash(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash));
   }
@@ -3,6 +3,10 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <new>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
 
 #include "hash.h"
 
@@ -10,6 +14,10 @@
 #include <Windows.h>
 #else
 #include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
 #endif
 
 using std::bad_alloc;
@@ -20,37 +28,209 @@ namespace Crypto {
     MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff)
   };
 
+  const char *cn_context::page_mode_name(page_mode mode) {
+    switch (mode) {
+    case huge_pages:
+      return "huge pages";
+    case transparent_huge_pages:
+      return "transparent huge pages";
+    default:
+      return "default pages";
+    }
+  }
+
+  size_t cn_slow_hash_ways(size_t threads) {
+    const size_t SCRATCHPAD_SIZE = 2 * 1024 * 1024;
+
+    // when the cache size is unknown it stays zero and single hashing is used
+    size_t cache_size = 0;
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l3 > 0) {
+      cache_size = static_cast<size_t>(l3);
+    }
+#endif
+
+    if (threads == 0) {
+      threads = 1;
+    }
+
+    size_t scratchpads = cache_size / SCRATCHPAD_SIZE;
+    if (scratchpads >= 4 * threads) {
+      return 4;
+    }
+
+    return scratchpads >= 2 * threads ? 2 : 1;
+  }
+
 #if defined(WIN32)
 
-  cn_context::cn_context() {
-    data = VirtualAlloc(nullptr, MAP_SIZE, MEM_COMMIT, PAGE_READWRITE);
+  namespace {
+
+    void *allocate_large_pages(size_t &size) {
+      size_t large_page = GetLargePageMinimum();
+      if (large_page == 0) {
+        return nullptr;
+      }
+
+      // fails without SeLockMemoryPrivilege, the caller falls back to default pages then
+      size = (MAP_SIZE + large_page - 1) & ~(large_page - 1);
+      return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+
+  }
+
+  cn_context::cn_context(page_mode pages) : m_mapSize(MAP_SIZE), m_pages(huge_pages) {
+    data = pages == huge_pages ? allocate_large_pages(m_mapSize) : nullptr;
+    if (data == nullptr) {
+      m_mapSize = MAP_SIZE;
+      m_pages = default_pages;
+      data = VirtualAlloc(nullptr, MAP_SIZE, MEM_COMMIT, PAGE_READWRITE);
+    }
+
     if (data == nullptr) {
       throw bad_alloc();
     }
+
+    m_map = data;
   }
 
   cn_context::~cn_context() noexcept(false) {
-    if (!VirtualFree(data, 0, MEM_RELEASE)) {
+    if (!VirtualFree(m_map, 0, MEM_RELEASE)) {
       throw bad_alloc();
     }
   }
 
 #else
 
-  cn_context::cn_context() {
+  namespace {
+
+    // The scratchpad takes exactly one huge page, the rest of the context (about 400 bytes) is
+    // mapped on a default page right after it, so the context stays contiguous without
+    // wasting a second huge page.
+    const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    static_assert(SLOW_HASH_CONTEXT_SIZE > HUGE_PAGE_SIZE && SLOW_HASH_CONTEXT_SIZE - HUGE_PAGE_SIZE < 4096,
+      "The scratchpad has to fill exactly one huge page");
+
+    size_t tail_map_size() {
+      size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+      return (SLOW_HASH_CONTEXT_SIZE - HUGE_PAGE_SIZE + page - 1) & ~(page - 1);
+    }
+
+    // Keeps the scratchpad on the NUMA node of the thread that creates the context.
+    // Contexts are created by the hashing threads themselves, so the pages touched
+    // below end up local to them. Errors are ignored: the kernel default policy is
+    // first touch anyway, this only overrides an interleaving process policy.
+    void bind_to_local_node(void *addr, size_t size) {
+#if defined(__linux__) && defined(SYS_mbind)
+      const int MPOL_LOCAL_POLICY = 4;
+      syscall(SYS_mbind, addr, size, MPOL_LOCAL_POLICY, nullptr, 0, 0);
+#endif
+    }
+
+#if defined(MAP_HUGETLB) || defined(MADV_HUGEPAGE)
+    // madvise succeeds even when transparent huge pages are switched off, the active
+    // mode is the bracketed one, e.g. "always [madvise] never"
+    bool transparent_huge_pages_enabled() {
+      std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+      std::string modes;
+      return std::getline(file, modes) && modes.find('[') != std::string::npos && modes.find("[never]") == std::string::npos;
+    }
+
+    // Reserves a range for a huge page aligned scratchpad followed by |tailSize| bytes,
+    // the unaligned ends of the reservation are released.
+    char *reserve_context(size_t tailSize) {
+      size_t reserveSize = 2 * HUGE_PAGE_SIZE + tailSize;
+      void *reserved = mmap(nullptr, reserveSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (reserved == MAP_FAILED) {
+        return nullptr;
+      }
+
+      uintptr_t begin = reinterpret_cast<uintptr_t>(reserved);
+      uintptr_t start = (begin + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+      uintptr_t end = start + HUGE_PAGE_SIZE + tailSize;
+      if (start != begin) {
+        munmap(reserved, start - begin);
+      }
+
+      if (end != begin + reserveSize) {
+        munmap(reinterpret_cast<void *>(end), begin + reserveSize - end);
+      }
+
+      return reinterpret_cast<char *>(start);
+    }
+
+    // |scratchpadFlags| select the pages of the scratchpad, |advice| is applied to it when not zero
+    void *map_context(size_t tailSize, int scratchpadFlags, int advice) {
+      char *start = reserve_context(tailSize);
+      if (start == nullptr) {
+        return nullptr;
+      }
+
+      if (mmap(start, HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | scratchpadFlags, -1, 0) == MAP_FAILED ||
+          (advice != 0 && madvise(start, HUGE_PAGE_SIZE, advice) != 0) ||
+          mmap(start + HUGE_PAGE_SIZE, tailSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED) {
+        munmap(start, HUGE_PAGE_SIZE + tailSize);
+        return nullptr;
+      }
+
+      return start;
+    }
+#endif
+
+    void *map_huge_pages(size_t tailSize) {
+#if defined(MAP_HUGETLB)
+      return map_context(tailSize, MAP_HUGETLB, 0);
+#else
+      return nullptr;
+#endif
+    }
+
+    void *map_transparent_huge_pages(size_t tailSize) {
+#if defined(MADV_HUGEPAGE)
+      return transparent_huge_pages_enabled() ? map_context(tailSize, 0, MADV_HUGEPAGE) : nullptr;
+#else
+      return nullptr;
+#endif
+    }
+
+  }
+
+  cn_context::cn_context(page_mode pages) : m_map(nullptr), m_pages(huge_pages) {
+    size_t tailSize = tail_map_size();
+    if (pages == huge_pages) {
+      m_map = map_huge_pages(tailSize);
+    }
+
+    if (m_map == nullptr && pages != default_pages) {
+      m_pages = transparent_huge_pages;
+      m_map = map_transparent_huge_pages(tailSize);
+    }
+
+    if (m_map != nullptr) {
+      m_mapSize = HUGE_PAGE_SIZE + tailSize;
+      // populate now, so that the first hash does not pay for the page faults
+      bind_to_local_node(m_map, m_mapSize);
+      memset(m_map, 0, m_mapSize);
+    } else {
+      m_pages = default_pages;
+      m_mapSize = MAP_SIZE;
 #if !defined(__APPLE__)
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+      m_map = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
 #else
-    data = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+      m_map = mmap(nullptr, MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
 #endif
-    if (data == MAP_FAILED) {
-      throw bad_alloc();
+      if (m_map == MAP_FAILED) {
+        throw bad_alloc();
+      }
     }
-    mlock(data, MAP_SIZE);
+
+    data = m_map;
+    mlock(data, m_mapSize);
   }
 
   cn_context::~cn_context() noexcept(false) {
-    if (munmap(data, MAP_SIZE) != 0) {
+    if (munmap(m_map, m_mapSize) != 0) {
       throw bad_alloc();
     }
   }
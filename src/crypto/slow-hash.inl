@@ -2,19 +2,20 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
-static void
 #if defined(AESNI)
-cn_slow_hash_aesni
+#define CN_FN(name) name##_aesni
 #else
-cn_slow_hash_noaesni
+#define CN_FN(name) name##_noaesni
 #endif
-(size_t majorVersion, void *restrict context, const void *restrict data, size_t length, void *restrict hash, bool walletkey)
-{
+
 #define ctx ((struct cn_ctx *) context)
+
+// fills the scratchpad from the keccak state of the input
+static inline void CN_FN(cn_explode)(void *restrict context, const void *restrict data, size_t length)
+{
   ALIGNED_DECL(uint8_t ExpandedKey[256], 16);
   size_t i;
-  __m128i *longoutput, *expkey, *xmminput, b_x;
-  ALIGNED_DECL(uint64_t a[2], 16);
+  __m128i *longoutput, *expkey, *xmminput;
   hash_process(&ctx->state.hs, (const uint8_t*) data, length);
 
   memcpy(ctx->text, ctx->state.init, INIT_SIZE_BYTE);
@@ -73,12 +74,12 @@ cn_slow_hash_noaesni
     ctx->a[i] = ((uint64_t *)ctx->state.k)[i] ^  ((uint64_t *)ctx->state.k)[i+4];
     ctx->b[i] = ((uint64_t *)ctx->state.k)[i+2] ^  ((uint64_t *)ctx->state.k)[i+6];
   }
+}
 
-  b_x = _mm_load_si128((__m128i *)ctx->b);
-  a[0] = ctx->a[0];
-  a[1] = ctx->a[1];
-
-  for(i = 0; likely(i < 0x80000); i++)
+// one iteration of the memory-hard loop, |a| and |b_x| carry the lane state between iterations
+static inline __attribute__((always_inline)) void CN_FN(cn_mix_step)(void *restrict context, uint64_t *a, __m128i *b_x_state)
+{
+  __m128i b_x = *b_x_state;
   {
     __m128i c_x = _mm_load_si128((__m128i *)&ctx->long_state[a[0] & 0x1FFFF0]);
     __m128i a_x = _mm_load_si128((__m128i *)a);
@@ -129,6 +130,58 @@ cn_slow_hash_noaesni
     b_x = c_x;
     //__builtin_prefetch(&ctx->long_state[a[0] & 0x1FFFF0], 0, 3);
   }
+  *b_x_state = b_x;
+}
+
+static inline __attribute__((always_inline)) void CN_FN(cn_mix)(void *restrict context)
+{
+  size_t i;
+  ALIGNED_DECL(uint64_t a[2], 16);
+  __m128i b_x = _mm_load_si128((__m128i *)ctx->b);
+  a[0] = ctx->a[0];
+  a[1] = ctx->a[1];
+
+  for(i = 0; likely(i < 0x80000); i++)
+  {
+    CN_FN(cn_mix_step)(context, a, &b_x);
+  }
+}
+
+// Runs the loops of |ways| lanes side by side. The lanes are independent, so the
+// latency of the aesenc/mul chain of one lane is hidden behind the work of the others.
+static inline __attribute__((always_inline)) void CN_FN(cn_mix_multi)(void *const *contexts, size_t ways)
+{
+  size_t i, k;
+  ALIGNED_DECL(uint64_t a[CN_SLOW_HASH_MAX_WAYS][2], 16);
+  __m128i b_x[CN_SLOW_HASH_MAX_WAYS];
+
+  for (k = 0; k < ways; k++)
+  {
+    const struct cn_ctx *lane = (const struct cn_ctx *) contexts[k];
+    b_x[k] = _mm_load_si128((const __m128i *)lane->b);
+    a[k][0] = lane->a[0];
+    a[k][1] = lane->a[1];
+  }
+
+  for(i = 0; likely(i < 0x80000); i++)
+  {
+    for (k = 0; k < ways; k++)
+    {
+      CN_FN(cn_mix_step)(contexts[k], a[k], &b_x[k]);
+    }
+  }
+}
+
+// mixes the scratchpad back into the state and computes the final hash
+static inline void CN_FN(cn_implode)(void *restrict context, void *restrict hash, bool walletkey)
+{
+  ALIGNED_DECL(uint8_t ExpandedKey[256], 16);
+  size_t i;
+  __m128i *longoutput, *expkey, *xmminput;
+
+  longoutput = (__m128i *) ctx->long_state;
+  expkey = (__m128i *) ExpandedKey;
+  xmminput = (__m128i *) ctx->text;
 
   memcpy(ctx->text, ctx->state.init, INIT_SIZE_BYTE);
 #if defined(AESNI)
@@ -191,3 +244,68 @@ cn_slow_hash_noaesni
     extra_hashes[ctx->state.hs.b[0] & 7](&ctx->state, 200, hash);
   }
 }
+
+static void
+#if defined(AESNI)
+cn_slow_hash_aesni
+#else
+cn_slow_hash_noaesni
+#endif
+(size_t majorVersion, void *restrict context, const void *restrict data, size_t length, void *restrict hash, bool walletkey)
+{
+  CN_FN(cn_explode)(context, data, length);
+  CN_FN(cn_mix)(context);
+  CN_FN(cn_implode)(context, hash, walletkey);
+}
+
+static void CN_FN(cn_slow_hash_x2)(void *const *contexts, const void *const *data, size_t length, char *hashes)
+{
+  size_t k;
+  for (k = 0; k < 2; k++)
+    CN_FN(cn_explode)(contexts[k], data[k], length);
+  CN_FN(cn_mix_multi)(contexts, 2);
+  for (k = 0; k < 2; k++)
+    CN_FN(cn_implode)(contexts[k], hashes + k * HASH_SIZE, false);
+}
+
+static void CN_FN(cn_slow_hash_x4)(void *const *contexts, const void *const *data, size_t length, char *hashes)
+{
+  size_t k;
+  for (k = 0; k < 4; k++)
+    CN_FN(cn_explode)(contexts[k], data[k], length);
+  CN_FN(cn_mix_multi)(contexts, 4);
+  for (k = 0; k < 4; k++)
+    CN_FN(cn_implode)(contexts[k], hashes + k * HASH_SIZE, false);
+}
+
+static void
+#if defined(AESNI)
+cn_slow_hash_multi_aesni
+#else
+cn_slow_hash_multi_noaesni
+#endif
+(size_t majorVersion, void *const *contexts, const void *const *data, size_t length, char *hashes, size_t count)
+{
+  size_t k;
+  switch (count)
+  {
+  case 4:
+    CN_FN(cn_slow_hash_x4)(contexts, data, length, hashes);
+    break;
+  case 2:
+    CN_FN(cn_slow_hash_x2)(contexts, data, length, hashes);
+    break;
+  default:
+    for (k = 0; k < count; k++)
+    {
+#if defined(AESNI)
+      cn_slow_hash_aesni(majorVersion, contexts[k], data[k], length, hashes + k * HASH_SIZE, false);
+#else
+      cn_slow_hash_noaesni(majorVersion, contexts[k], data[k], length, hashes + k * HASH_SIZE, false);
+#endif
+    }
+  }
+}
+
+#undef ctx
+#undef CN_FN
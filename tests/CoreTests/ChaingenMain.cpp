@@ -17,6 +17,7 @@
 #include "TransactionTests.h"
 #include "TransactionValidation.h"
 #include "RandomOuts.h"
+#include "SendRawTransactions.h"
 
 namespace po = boost::program_options;
 
@@ -176,6 +177,7 @@ int main(int argc, char* argv[])
 
     GENERATE_AND_PLAY(gen_block_reward);
     GENERATE_AND_PLAY(GetRandomOutputs);
+    GENERATE_AND_PLAY(SendRawTransactions);
 
     std::cout << (failed_tests.empty() ? concolor::green : concolor::magenta);
     std::cout << "\nREPORT:\n";
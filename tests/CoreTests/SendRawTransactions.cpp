@@ -0,0 +1,176 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "SendRawTransactions.h"
+#include "TestGenerator.h"
+
+#include "Common/StringOutputStream.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
+#include "HTTP/HttpRequest.h"
+#include "HTTP/HttpResponse.h"
+#include "P2p/NetNode.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Rpc/RpcServer.h"
+#include "Serialization/SerializationTools.h"
+#include "System/Dispatcher.h"
+
+#include "Logging/LoggerManager.h"
+using namespace Logging;
+using namespace CryptoNote;
+static LoggerManager sendRawManager;
+static LoggerRef sendRawLogger(sendRawManager, "send raw transactions tests");
+
+namespace {
+
+const size_t TRANSACTION_COUNT = 3;
+
+BinaryArray corruptedSignature(const Transaction& tx) {
+  Transaction corrupted = tx;
+  corrupted.signatures[0][0].c.data[0] ^= 1;
+  return toBinaryArray(corrupted);
+}
+
+template<typename Request, typename Response>
+bool invokeJson(HttpServer& server, const std::string& url, const Request& req, Response& res) {
+  HttpRequest httpReq;
+  httpReq.setUrl(url);
+  httpReq.setBody(storeToJson(req));
+
+  HttpResponse httpRes;
+  server.processRequest(httpReq, httpRes);
+  return httpRes.getStatus() == HttpResponse::STATUS_200 && loadFromJson(res, httpRes.getBody());
+}
+
+template<typename Request, typename Response>
+bool invokeBinary(HttpServer& server, const std::string& url, const Request& req, Response& res) {
+  HttpRequest httpReq;
+  httpReq.setUrl(url);
+  httpReq.setBody(storeToBinaryKeyValue(req));
+
+  HttpResponse httpRes;
+  server.processRequest(httpReq, httpRes);
+
+  std::string body = httpRes.getBody();
+  if (httpRes.getBodyWriter()) {
+    Common::StringOutputStream stream(body);
+    httpRes.getBodyWriter()(stream);
+  }
+
+  return httpRes.getStatus() == HttpResponse::STATUS_200 && loadFromBinaryKeyValue(res, body);
+}
+
+}
+
+SendRawTransactions::SendRawTransactions() : test_chain_unit_base(sendRawLogger) {
+  // the RPC server serves the transactions without a synchronized P2P node on testnet only
+  m_currency = CurrencyBuilder(m_logger.getLogger()).testnet(true).currency();
+  REGISTER_CALLBACK_METHOD(SendRawTransactions, checkSendRawTransactions);
+}
+
+bool SendRawTransactions::generate(std::vector<test_event_entry>& events) const {
+  TestGenerator generator(m_currency, events);
+
+  // one unlocked coinbase output for every transaction
+  generator.generateBlocks(m_currency.minedMoneyUnlockWindow() + TRANSACTION_COUNT);
+
+  // every transaction spends its own output, the generator sees the outputs spent by the
+  // transactions already added to the events
+  for (size_t i = 0; i < TRANSACTION_COUNT; ++i) {
+    auto builder = generator.createTxBuilder(
+      generator.minerAccount, generator.minerAccount, MK_COINS(1), m_currency.minimumFee());
+
+    generator.addEvent(builder.build());
+  }
+
+  std::vector<test_event_entry> transactions(events.end() - TRANSACTION_COUNT, events.end());
+  events.resize(events.size() - TRANSACTION_COUNT);
+  generator.addCallback("checkSendRawTransactions");
+  events.insert(events.end(), transactions.begin(), transactions.end());
+
+  return true;
+}
+
+bool SendRawTransactions::check_tx_verification_context(const tx_verification_context& tvc, bool tx_added, size_t event_idx, const Transaction& tx) {
+  // the transactions come after the callback, which has already put them into the pool
+  return !tvc.m_verifivation_failed && !tx_added;
+}
+
+#define CHECK(cond) if((cond) == false) { LOG_ERROR("Condition "#cond" failed"); return false; }
+
+bool SendRawTransactions::checkSendRawTransactions(core& c, size_t ev_index, const std::vector<test_event_entry>& events) {
+  std::vector<Transaction> txs;
+  for (size_t i = 1; i <= TRANSACTION_COUNT; ++i) {
+    txs.push_back(boost::get<Transaction>(events[ev_index + i]));
+  }
+
+  // the copy with a broken ring signature goes first, it spends the same key image as the
+  // valid transaction and must not block it
+  std::vector<BinaryArray> blobs = { corruptedSignature(txs[0]), toBinaryArray(txs[0]), BinaryArray(100, 0xff), BinaryArray() };
+  std::vector<tx_verification_context> tvcs;
+  CHECK(c.handle_incoming_txs(blobs, tvcs));
+  CHECK(tvcs.size() == blobs.size());
+  CHECK(tvcs[0].m_verifivation_failed);
+  CHECK(!tvcs[1].m_verifivation_failed && tvcs[1].m_added_to_pool);
+  CHECK(tvcs[2].m_verifivation_failed);
+  CHECK(tvcs[3].m_verifivation_failed);
+  CHECK(c.get_pool_transactions_count() == 1);
+
+  System::Dispatcher dispatcher;
+  CryptoNoteProtocolHandler protocol(c.currency(), dispatcher, c, nullptr, sendRawLogger.getLogger());
+  NodeServer p2p(dispatcher, protocol, sendRawLogger.getLogger());
+  RpcServer rpc(dispatcher, sendRawLogger.getLogger(), c, p2p, protocol);
+  HttpServer& server = rpc;
+
+  COMMAND_RPC_SEND_RAW_TXS::request jsonReq;
+  COMMAND_RPC_SEND_RAW_TXS::response jsonRes;
+  jsonReq.txs_as_hex = { Common::toHex(corruptedSignature(txs[1])), Common::toHex(toBinaryArray(txs[1])), "not a hex", "" };
+  CHECK(invokeJson(server, "/sendrawtransactions", jsonReq, jsonRes));
+  CHECK(jsonRes.status == CORE_RPC_STATUS_OK);
+  CHECK(jsonRes.results.size() == jsonReq.txs_as_hex.size());
+  CHECK(jsonRes.results[0].status == "Failed");
+  CHECK(jsonRes.results[1].status == CORE_RPC_STATUS_OK);
+  CHECK(jsonRes.results[1].hash == Common::podToHex(getObjectHash(txs[1])));
+  CHECK(jsonRes.results[2].status == "Failed");
+  CHECK(jsonRes.results[3].status == "Failed");
+  CHECK(c.get_pool_transactions_count() == 2);
+
+  COMMAND_RPC_SEND_RAW_TXS_BIN::request binReq;
+  COMMAND_RPC_SEND_RAW_TXS_BIN::response binRes;
+  binReq.txs = { Common::asString(corruptedSignature(txs[2])), Common::asString(toBinaryArray(txs[2])), std::string(100, '\xff') };
+  CHECK(invokeBinary(server, "/sendrawtransactions.bin", binReq, binRes));
+  CHECK(binRes.status == CORE_RPC_STATUS_OK);
+  CHECK(binRes.results.size() == binReq.txs.size());
+  CHECK(binRes.results[0].status == "Failed");
+  CHECK(binRes.results[1].status == CORE_RPC_STATUS_OK);
+  CHECK(binRes.results[1].hash == Common::podToHex(getObjectHash(txs[2])));
+  CHECK(binRes.results[2].status == "Failed");
+  CHECK(c.get_pool_transactions_count() == 3);
+
+  // a full batch is processed, a bigger one is refused as a whole
+  jsonReq.txs_as_hex.assign(COMMAND_RPC_SEND_RAW_TXS_MAX_COUNT, "");
+  CHECK(invokeJson(server, "/sendrawtransactions", jsonReq, jsonRes));
+  CHECK(jsonRes.status == CORE_RPC_STATUS_OK);
+  CHECK(jsonRes.results.size() == COMMAND_RPC_SEND_RAW_TXS_MAX_COUNT);
+
+  jsonReq.txs_as_hex.push_back("");
+  jsonRes = COMMAND_RPC_SEND_RAW_TXS::response();
+  CHECK(invokeJson(server, "/sendrawtransactions", jsonReq, jsonRes));
+  // loadFromJson drops the spaces of the status text
+  CHECK(jsonRes.status != CORE_RPC_STATUS_OK);
+  CHECK(jsonRes.results.empty());
+
+  binReq.txs.assign(COMMAND_RPC_SEND_RAW_TXS_MAX_COUNT, "");
+  CHECK(invokeBinary(server, "/sendrawtransactions.bin", binReq, binRes));
+  CHECK(binRes.status == CORE_RPC_STATUS_OK);
+  CHECK(binRes.results.size() == COMMAND_RPC_SEND_RAW_TXS_MAX_COUNT);
+
+  binReq.txs.push_back("");
+  binRes = COMMAND_RPC_SEND_RAW_TXS_BIN::response();
+  CHECK(invokeBinary(server, "/sendrawtransactions.bin", binReq, binRes));
+  CHECK(binRes.status == "Failed, too many transactions");
+  CHECK(binRes.results.empty());
+
+  CHECK(c.get_pool_transactions_count() == 3);
+  return true;
+}
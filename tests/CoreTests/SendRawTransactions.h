@@ -0,0 +1,23 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once 
+
+#include "Chaingen.h"
+
+struct SendRawTransactions : public test_chain_unit_base
+{
+  SendRawTransactions();
+
+  bool generate(std::vector<test_event_entry>& events) const;
+
+  // the transactions follow the callback only to be handed to it, the callback has already put
+  // them to the pool, so their replay is a double spend
+  bool check_tx_verification_context(const CryptoNote::tx_verification_context& tvc, bool tx_added, size_t event_idx, const CryptoNote::Transaction& tx);
+
+private:
+
+  bool checkSendRawTransactions(CryptoNote::core& c, size_t ev_index, const std::vector<test_event_entry>& events);
+
+};
@@ -4,10 +4,15 @@
 
 #pragma once
 
+#include <iomanip>
+#include <iostream>
+
 #include "Common/StringTools.h"
 #include "crypto/crypto.h"
 #include "CryptoNoteCore/CryptoNoteBasic.h"
 
+#include "PerformanceTests.h"
+
 class test_cn_slow_hash {
 public:
   static const size_t loop_count = 10;
@@ -44,3 +49,49 @@ private:
   Crypto::Hash m_expected_hash;
   Crypto::cn_context m_context;
 };
+
+// Hashes per second with the scratchpad on each kind of pages, the modes the system cannot
+// provide are reported and skipped.
+inline void compare_cn_slow_hash_pages() {
+  const size_t hash_count = 100;
+  const char data[] = "caveat emptor";
+  const Crypto::cn_context::page_mode modes[] = {
+    Crypto::cn_context::default_pages,
+    Crypto::cn_context::transparent_huge_pages,
+    Crypto::cn_context::huge_pages
+  };
+
+  double default_rate = 0;
+  for (Crypto::cn_context::page_mode mode : modes) {
+    Crypto::cn_context context(mode);
+    if (context.pages() != mode) {
+      std::cout << "cn_slow_hash with " << Crypto::cn_context::page_mode_name(mode) << " - not available\n";
+      continue;
+    }
+
+    Crypto::Hash hash;
+    Crypto::cn_slow_hash(1, context, data, sizeof(data) - 1, hash);
+
+    performance_timer timer;
+    timer.start();
+    for (size_t i = 0; i < hash_count; ++i) {
+      Crypto::cn_slow_hash(1, context, data, sizeof(data) - 1, hash);
+    }
+
+    int elapsed = timer.elapsed_ms();
+    double rate = elapsed > 0 ? hash_count * 1000.0 / elapsed : 0;
+    if (mode == Crypto::cn_context::default_pages) {
+      default_rate = rate;
+    }
+
+    std::cout << "cn_slow_hash with " << Crypto::cn_context::page_mode_name(mode) << ": " <<
+      std::fixed << std::setprecision(1) << rate << " H/s";
+    if (default_rate > 0 && mode != Crypto::cn_context::default_pages) {
+      std::cout << " (" << std::setprecision(2) << rate / default_rate << "x default pages)";
+    }
+
+    std::cout << '\n';
+  }
+
+  std::cout << std::endl;
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <sstream>
+
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Serialization/SerializationTools.h"
+
+// json_stream is the JsonValue tree printed or read through a std::stream, json_text prints
+// and reads the text directly
+enum json_path {
+  json_stream,
+  json_text
+};
+
+struct json_block_headers {
+  std::vector<CryptoNote::block_header_response> headers;
+  std::string status;
+
+  void serialize(CryptoNote::ISerializer& s) {
+    KV_MEMBER(headers)
+    KV_MEMBER(status)
+  }
+};
+
+inline json_block_headers make_json_block_headers() {
+  json_block_headers value;
+  value.status = CORE_RPC_STATUS_OK;
+  value.headers.resize(1000);
+  for (size_t i = 0; i < value.headers.size(); ++i) {
+    CryptoNote::block_header_response& header = value.headers[i];
+    header.major_version = 1;
+    header.minor_version = 0;
+    header.timestamp = 1500000000 + i * 120;
+    header.prev_hash = std::string(64, 'a');
+    header.nonce = static_cast<uint32_t>(i * 2654435761u);
+    header.orphan_status = false;
+    header.height = i;
+    header.depth = 1000 - i;
+    header.hash = std::string(64, 'b');
+    header.difficulty = 1000000 + i;
+    header.reward = 1490116119384 - i;
+  }
+
+  return value;
+}
+
+template<json_path path>
+class test_store_to_json
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool init()
+  {
+    m_headers = make_json_block_headers();
+    return true;
+  }
+
+  bool test()
+  {
+    std::string text = path == json_stream ? CryptoNote::storeToJsonValue(m_headers).toString() : CryptoNote::storeToJson(m_headers);
+    return !text.empty();
+  }
+
+private:
+  json_block_headers m_headers;
+};
+
+template<json_path path>
+class test_load_from_json
+{
+public:
+  static const size_t loop_count = 100;
+
+  bool init()
+  {
+    m_text = CryptoNote::storeToJson(make_json_block_headers());
+    return true;
+  }
+
+  bool test()
+  {
+    Common::JsonValue value;
+    if (path == json_stream) {
+      std::istringstream stream(m_text);
+      stream >> value;
+    } else {
+      value = Common::JsonValue::fromString(m_text);
+    }
+
+    json_block_headers headers;
+    CryptoNote::loadFromJsonValue(headers, value);
+    return headers.headers.size() == 1000;
+  }
+
+private:
+  std::string m_text;
+};
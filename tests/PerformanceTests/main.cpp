@@ -15,6 +15,7 @@
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
 #include "IsOutToAccount.h"
+#include "JsonSerialization.h"
 
 int main(int argc, char** argv)
 {
@@ -57,7 +58,17 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE0(test_derive_public_key);
   TEST_PERFORMANCE0(test_derive_secret_key);
 
+  TEST_PERFORMANCE1(test_store_to_json, json_stream);
+  TEST_PERFORMANCE1(test_store_to_json, json_text);
+  TEST_PERFORMANCE1(test_load_from_json, json_stream);
+  TEST_PERFORMANCE1(test_load_from_json, json_text);
+
+  {
+    Crypto::cn_context context;
+    std::cout << "cn_slow_hash scratchpad uses " << Crypto::cn_context::page_mode_name(context.pages()) << std::endl;
+  }
   TEST_PERFORMANCE0(test_cn_slow_hash);
+  compare_cn_slow_hash_pages();
 
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
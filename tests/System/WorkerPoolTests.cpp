@@ -0,0 +1,161 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <System/WorkerPool.h>
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace System;
+
+class WorkerPoolTests : public testing::Test {
+public:
+  Dispatcher dispatcher;
+};
+
+TEST_F(WorkerPoolTests, runsOperationOnWorkerThread) {
+  WorkerPool pool(dispatcher, 1, 1);
+  std::thread::id operationThread;
+
+  ASSERT_TRUE(pool.run([&] { operationThread = std::this_thread::get_id(); }));
+  ASSERT_NE(std::this_thread::get_id(), operationThread);
+}
+
+TEST_F(WorkerPoolTests, runRethrowsException) {
+  WorkerPool pool(dispatcher, 1, 1);
+  ASSERT_THROW(pool.run([] { throw std::string("Hi there!"); }), std::string);
+}
+
+TEST_F(WorkerPoolTests, dispatcherRunsOtherContextsMeanwhile) {
+  WorkerPool pool(dispatcher, 1, 1);
+  Event contextDone(dispatcher);
+  ContextGroup cg(dispatcher);
+  cg.spawn([&] { contextDone.set(); });
+
+  ASSERT_TRUE(pool.run([] { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }));
+  ASSERT_TRUE(contextDone.get());
+  cg.wait();
+}
+
+TEST_F(WorkerPoolTests, refusesOperationsOverQueueLimit) {
+  WorkerPool pool(dispatcher, 1, 1);
+  std::atomic<bool> started(false);
+  std::atomic<bool> release(false);
+  size_t completed = 0;
+  ContextGroup cg(dispatcher);
+
+  cg.spawn([&] {
+    ASSERT_TRUE(pool.run([&] {
+      started = true;
+      while (!release) {
+        std::this_thread::yield();
+      }
+    }));
+
+    ++completed;
+  });
+
+  cg.spawn([&] {
+    while (!started) {
+      dispatcher.yield();
+    }
+
+    ASSERT_TRUE(pool.run([] {}));
+    ++completed;
+  });
+
+  cg.spawn([&] {
+    while (!started || pool.queueSize() == 0) {
+      dispatcher.yield();
+    }
+
+    ASSERT_FALSE(pool.run([] {}));
+    release = true;
+  });
+
+  cg.wait();
+  ASSERT_EQ(2, completed);
+}
+
+TEST_F(WorkerPoolTests, idleThreadsTakeOperationsWithoutQueue) {
+  WorkerPool pool(dispatcher, 2, 0);
+  std::atomic<bool> started(false);
+  std::atomic<bool> release(false);
+  size_t completed = 0;
+  ContextGroup cg(dispatcher);
+
+  cg.spawn([&] {
+    ASSERT_TRUE(pool.run([&] {
+      started = true;
+      while (!release) {
+        std::this_thread::yield();
+      }
+    }));
+
+    ++completed;
+  });
+
+  cg.spawn([&] {
+    while (!started) {
+      dispatcher.yield();
+    }
+
+    // the other thread is idle
+    ASSERT_TRUE(pool.run([] {}));
+    ++completed;
+    release = true;
+  });
+
+  cg.wait();
+  ASSERT_EQ(2, completed);
+}
+
+TEST_F(WorkerPoolTests, refusesOperationsWithoutIdleThreadAndQueue) {
+  WorkerPool pool(dispatcher, 1, 0);
+  std::atomic<bool> started(false);
+  std::atomic<bool> release(false);
+  ContextGroup cg(dispatcher);
+
+  cg.spawn([&] {
+    ASSERT_TRUE(pool.run([&] {
+      started = true;
+      while (!release) {
+        std::this_thread::yield();
+      }
+    }));
+  });
+
+  cg.spawn([&] {
+    while (!started) {
+      dispatcher.yield();
+    }
+
+    ASSERT_FALSE(pool.run([] {}));
+    release = true;
+  });
+
+  cg.wait();
+}
+
+TEST_F(WorkerPoolTests, interruptDoesNotAbandonOperation) {
+  WorkerPool pool(dispatcher, 1, 1);
+  bool finished = false;
+  ContextGroup cg(dispatcher);
+  cg.spawn([&] {
+    ASSERT_TRUE(pool.run([&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      finished = true;
+    }));
+    ASSERT_TRUE(dispatcher.interrupted());
+  });
+
+  cg.interrupt();
+  cg.wait();
+  ASSERT_TRUE(finished);
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "crypto/hash.h"
+#include "CryptoNoteConfig.h"
+
+namespace {
+
+const uint8_t MAJOR_VERSIONS[] = { CryptoNote::BLOCK_MAJOR_VERSION_1 };
+
+class CnSlowHashMultiTest : public ::testing::Test {
+public:
+  CnSlowHashMultiTest() : inputs({ "caveat emptor", "ex nihilo nihil fit", "ad infinitum et ", "veni, vidi, vici." }) {
+    // the interleaved kernels hash inputs of one length
+    for (std::string& input : inputs) {
+      input.resize(inputs[0].size(), '.');
+    }
+
+    for (size_t i = 0; i < Crypto::CN_SLOW_HASH_MAX_WAYS; ++i) {
+      contexts.emplace_back(new Crypto::cn_context());
+    }
+  }
+
+  ~CnSlowHashMultiTest() {
+    // the other tests use the best kernels
+    Crypto::cn_slow_hash_select_aesni(true);
+  }
+
+  void checkMultiHashMatchesSingle() {
+    for (uint8_t majorVersion : MAJOR_VERSIONS) {
+      std::vector<Crypto::Hash> expected(inputs.size());
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        Crypto::cn_slow_hash(majorVersion, *contexts[0], inputs[i].data(), inputs[i].size(), expected[i]);
+      }
+
+      Crypto::cn_context* contextPointers[Crypto::CN_SLOW_HASH_MAX_WAYS];
+      const void* data[Crypto::CN_SLOW_HASH_MAX_WAYS];
+      for (size_t i = 0; i < Crypto::CN_SLOW_HASH_MAX_WAYS; ++i) {
+        contextPointers[i] = contexts[i].get();
+        data[i] = inputs[i].data();
+      }
+
+      for (size_t ways : { 2, 4 }) {
+        std::vector<Crypto::Hash> hashes(ways);
+        Crypto::cn_slow_hash_multi(majorVersion, contextPointers, data, inputs[0].size(), hashes.data(), ways);
+        for (size_t i = 0; i < ways; ++i) {
+          EXPECT_EQ(expected[i], hashes[i]) << "major version " << static_cast<int>(majorVersion) << ", " << ways << " ways, input " << i;
+        }
+      }
+    }
+  }
+
+protected:
+  std::vector<std::string> inputs;
+  std::vector<std::unique_ptr<Crypto::cn_context>> contexts;
+};
+
+}
+
+TEST_F(CnSlowHashMultiTest, portableKernelsMatchSingleHash) {
+  ASSERT_FALSE(Crypto::cn_slow_hash_select_aesni(false));
+  checkMultiHashMatchesSingle();
+}
+
+TEST_F(CnSlowHashMultiTest, aesniKernelsMatchSingleHash) {
+  if (!Crypto::cn_slow_hash_select_aesni(true)) {
+    std::cout << "AES-NI is not supported, skipped" << std::endl;
+    return;
+  }
+
+  checkMultiHashMatchesSingle();
+}
+
+TEST_F(CnSlowHashMultiTest, aesniAndPortableKernelsAgree) {
+  if (!Crypto::cn_slow_hash_select_aesni(true)) {
+    std::cout << "AES-NI is not supported, skipped" << std::endl;
+    return;
+  }
+
+  Crypto::Hash aesni;
+  Crypto::cn_slow_hash(CryptoNote::BLOCK_MAJOR_VERSION_1, *contexts[0], inputs[0].data(), inputs[0].size(), aesni);
+
+  Crypto::cn_slow_hash_select_aesni(false);
+  Crypto::Hash portable;
+  Crypto::cn_slow_hash(CryptoNote::BLOCK_MAJOR_VERSION_1, *contexts[0], inputs[0].data(), inputs[0].size(), portable);
+
+  ASSERT_EQ(aesni, portable);
+}
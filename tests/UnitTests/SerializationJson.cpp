@@ -0,0 +1,159 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <limits>
+
+#include "Rpc/JsonRpc.h"
+#include "Serialization/SerializationOverloads.h"
+#include "Serialization/SerializationTools.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+struct JsonTestItem {
+  std::string name;
+  std::array<uint8_t, 8> blob;
+  std::vector<uint32_t> values;
+
+  void serialize(ISerializer& s) {
+    s(name, "name");
+    s.binary(blob.data(), blob.size(), "blob");
+    s(values, "values");
+  }
+};
+
+struct JsonTestStruct {
+  uint8_t u8;
+  int16_t i16;
+  uint16_t u16;
+  int32_t i32;
+  uint32_t u32;
+  int64_t i64;
+  uint64_t u64;
+  bool flag;
+  std::string text;
+  std::vector<JsonTestItem> items;
+  std::vector<JsonTestItem> noItems;
+  JsonTestItem item;
+
+  void serialize(ISerializer& s) {
+    s(u8, "u8");
+    s(i16, "i16");
+    s(u16, "u16");
+    s(i32, "i32");
+    s(u32, "u32");
+    s(i64, "i64");
+    s(u64, "u64");
+    s(flag, "flag");
+    s(text, "text");
+    s(items, "items");
+    s(noItems, "no_items");
+    s(item, "item");
+  }
+};
+
+JsonTestStruct makeTestStruct() {
+  JsonTestStruct value;
+  value.u8 = 200;
+  value.i16 = -30000;
+  value.u16 = 60000;
+  value.i32 = std::numeric_limits<int32_t>::min();
+  value.u32 = std::numeric_limits<uint32_t>::max();
+  value.i64 = std::numeric_limits<int64_t>::min();
+  value.u64 = std::numeric_limits<uint64_t>::max();
+  value.flag = true;
+  value.text = "some_text";
+  value.item.name = "item";
+  value.item.blob.fill(0xab);
+  for (uint32_t i = 0; i < 3; ++i) {
+    JsonTestItem item;
+    item.name = "item" + std::to_string(i);
+    item.blob.fill(static_cast<uint8_t>(i));
+    item.values.assign(i, i * 1000);
+    value.items.push_back(item);
+  }
+
+  return value;
+}
+
+struct JsonTestReals {
+  std::vector<double> values;
+  double value;
+
+  void serialize(ISerializer& s) {
+    s(value, "value");
+    s(values, "values");
+  }
+};
+
+// members of JsonValue objects are sorted, printing a parsed text puts them in a canonical order
+std::string normalize(const std::string& text) {
+  return Common::JsonValue::fromStringWithWhiteSpaces(text).toString();
+}
+
+}
+
+TEST(JsonOutputTextSerializer, printsAsJsonValueTree) {
+  JsonTestStruct value = makeTestStruct();
+
+  std::string text = storeToJson(value);
+  std::string treeText = storeToJsonValue(value).toString();
+  ASSERT_NE(treeText, text);
+  ASSERT_EQ(treeText, normalize(text));
+}
+
+TEST(JsonOutputTextSerializer, printsRealsAsJsonValueTree) {
+  JsonTestReals reals;
+  reals.values = { 0.5, -1234.25, 1e20, 1.0 / 3 };
+  reals.value = 100;
+  ASSERT_EQ(storeToJsonValue(reals).toString(), storeToJson(reals));
+}
+
+TEST(JsonOutputTextSerializer, keepsSerializationOrder) {
+  JsonTestItem item;
+  item.name = "x";
+  item.blob.fill(1);
+  item.values = { 1, 2 };
+  ASSERT_EQ("{\"name\":\"x\",\"blob\":\"0101010101010101\",\"values\":[1,2]}", storeToJson(item));
+}
+
+TEST(JsonOutputTextSerializer, printsEmptyObject) {
+  JsonOutputTextSerializer s;
+  ASSERT_EQ("{}", s.takeText());
+}
+
+TEST(JsonOutputTextSerializer, loadsBack) {
+  JsonTestStruct value = makeTestStruct();
+  JsonTestStruct loaded;
+  ASSERT_TRUE(loadFromJson(loaded, storeToJson(value)));
+  ASSERT_EQ(value.i64, loaded.i64);
+  ASSERT_EQ(value.u64, loaded.u64);
+  ASSERT_EQ(value.text, loaded.text);
+  ASSERT_EQ(value.items.size(), loaded.items.size());
+  ASSERT_EQ(value.items[2].values, loaded.items[2].values);
+  ASSERT_EQ(value.item.blob, loaded.item.blob);
+}
+
+TEST(JsonRpcResponse, printsResultAsJsonValueTree) {
+  JsonTestStruct value = makeTestStruct();
+  Common::JsonValue id = Common::JsonValue::fromString("\"abc\"");
+
+  JsonRpc::JsonRpcResponse response;
+  response.setId(id);
+  response.setResult(value);
+
+  Common::JsonValue expected(Common::JsonValue::OBJECT);
+  expected.insert("id", id);
+  expected.insert("jsonrpc", std::string("2.0"));
+  expected.insert("result", storeToJsonValue(value));
+  ASSERT_EQ(expected.toString(), normalize(response.getBody()));
+
+  JsonTestStruct loaded;
+  ASSERT_TRUE(response.getResult(loaded));
+  ASSERT_EQ(value.text, loaded.text);
+}
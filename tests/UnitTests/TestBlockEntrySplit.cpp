@@ -0,0 +1,165 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Common/VectorOutputStream.h"
+#include "CryptoNoteCore/Blockchain.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+Transaction makeTransaction(uint8_t seed) {
+  Transaction tx;
+  tx.version = 1;
+  tx.unlockTime = 1000 + seed;
+
+  KeyInput keyInput;
+  keyInput.amount = 12345678 + seed;
+  keyInput.outputIndexes = { 1, 300, 70000 };
+  keyInput.keyImage.data[0] = seed;
+  tx.inputs.push_back(keyInput);
+
+  MultisignatureInput multisignatureInput;
+  multisignatureInput.amount = 500;
+  multisignatureInput.signatureCount = 2;
+  multisignatureInput.outputIndex = 7;
+  tx.inputs.push_back(multisignatureInput);
+
+  KeyOutput keyOutput;
+  keyOutput.key.data[1] = seed;
+  tx.outputs.push_back({ 5000000, keyOutput });
+
+  MultisignatureOutput multisignatureOutput;
+  multisignatureOutput.keys.resize(3);
+  multisignatureOutput.requiredSignatureCount = 2;
+  tx.outputs.push_back({ 100, multisignatureOutput });
+
+  tx.extra.assign(200, seed);
+  tx.signatures.resize(2);
+  tx.signatures[0].resize(3);
+  tx.signatures[1].resize(2);
+  tx.signatures[1][1].r.data[5] = seed;
+  return tx;
+}
+
+Transaction makeBaseTransaction() {
+  Transaction tx;
+  tx.version = 1;
+  tx.unlockTime = 60;
+
+  BaseInput input;
+  input.blockIndex = 50;
+  tx.inputs.push_back(input);
+
+  KeyOutput keyOutput;
+  tx.outputs.push_back({ 1000000000000, keyOutput });
+  tx.extra.assign(33, 1);
+  tx.signatures.resize(1);
+  return tx;
+}
+
+// the layout of Blockchain::BlockEntry in the block storage
+BinaryArray makeEntry(Block& block, std::vector<Transaction>& transactions) {
+  BinaryArray entry;
+  Common::VectorOutputStream stream(entry);
+  BinaryOutputStreamSerializer s(stream);
+
+  uint32_t height = 50;
+  uint64_t cumulativeSize = 123456;
+  uint64_t cumulativeDifficulty = 987654321;
+  uint64_t generatedCoins = 1ull << 50;
+  s(block, "block");
+  s(height, "height");
+  s(cumulativeSize, "block_cumulative_size");
+  s(cumulativeDifficulty, "cumulative_difficulty");
+  s(generatedCoins, "already_generated_coins");
+
+  uint64_t count = transactions.size();
+  s.beginArray(count, "transactions");
+  for (Transaction& tx : transactions) {
+    std::vector<uint32_t> indexes = { 3, 200, 100000 };
+    s(tx, "tx");
+    s(indexes, "indexes");
+  }
+
+  s.endArray();
+  return entry;
+}
+
+Block makeBlock(const std::vector<Transaction>& transactions) {
+  Block block;
+  block.majorVersion = BLOCK_MAJOR_VERSION_1;
+  block.minorVersion = 0;
+  block.timestamp = 1500000000;
+  block.nonce = 0xdeadbeef;
+  block.baseTransaction = transactions[0];
+  for (size_t i = 1; i < transactions.size(); ++i) {
+    block.transactionHashes.push_back(getObjectHash(transactions[i]));
+  }
+
+  return block;
+}
+
+}
+
+TEST(BlockEntrySplit, cutsBlockAndTransactions) {
+  std::vector<Transaction> transactions = { makeBaseTransaction(), makeTransaction(1), makeTransaction(2) };
+  Block block = makeBlock(transactions);
+  BinaryArray entry = makeEntry(block, transactions);
+
+  Blockchain::RawBlock raw;
+  ASSERT_TRUE(Blockchain::splitBlockEntry(entry, raw));
+  ASSERT_EQ(block.timestamp, raw.timestamp);
+  ASSERT_EQ(Common::asString(toBinaryArray(block)), raw.block);
+  ASSERT_EQ(2, raw.transactions.size());
+  ASSERT_EQ(Common::asString(toBinaryArray(transactions[1])), raw.transactions[0]);
+  ASSERT_EQ(Common::asString(toBinaryArray(transactions[2])), raw.transactions[1]);
+}
+
+TEST(BlockEntrySplit, cutsBlockWithoutTransactions) {
+  std::vector<Transaction> transactions = { makeBaseTransaction() };
+  Block block = makeBlock(transactions);
+  BinaryArray entry = makeEntry(block, transactions);
+
+  Blockchain::RawBlock raw;
+  ASSERT_TRUE(Blockchain::splitBlockEntry(entry, raw));
+  ASSERT_EQ(Common::asString(toBinaryArray(block)), raw.block);
+  ASSERT_TRUE(raw.transactions.empty());
+}
+
+TEST(BlockEntrySplit, rejectsTruncatedEntry) {
+  std::vector<Transaction> transactions = { makeBaseTransaction(), makeTransaction(1) };
+  Block block = makeBlock(transactions);
+  BinaryArray entry = makeEntry(block, transactions);
+
+  for (size_t size : { size_t(0), size_t(10), entry.size() / 2, entry.size() - 1 }) {
+    Blockchain::RawBlock raw;
+    ASSERT_FALSE(Blockchain::splitBlockEntry(BinaryArray(entry.begin(), entry.begin() + size), raw)) << size;
+  }
+}
+
+TEST(BlockEntrySplit, rejectsUnknownInputType) {
+  std::vector<Transaction> transactions = { makeBaseTransaction(), makeTransaction(1) };
+  Block block = makeBlock(transactions);
+  BinaryArray entry = makeEntry(block, transactions);
+
+  BinaryArray transactionBlob = toBinaryArray(transactions[1]);
+  auto transactionBegin = std::search(entry.begin(), entry.end(), transactionBlob.begin(), transactionBlob.end());
+  ASSERT_NE(entry.end(), transactionBegin);
+
+  // the version, the unlock time and the input count take 4 bytes here, then goes the input tag
+  ASSERT_EQ(0x02, *(transactionBegin + 4));
+  *(transactionBegin + 4) = 0x7f;
+  Blockchain::RawBlock raw;
+  ASSERT_FALSE(Blockchain::splitBlockEntry(entry, raw));
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <system_error>
+
+#include "HTTP/HttpParser.h"
+#include "HTTP/HttpParserErrorCodes.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const std::string POST_REQUEST =
+  "POST /getblocks.bin HTTP/1.1\r\n"
+  "Host: 127.0.0.1\r\n"
+  "Content-Length:   5  \r\n"
+  "TE: trailers\r\n"
+  "\r\n"
+  "hello";
+
+}
+
+TEST(HttpParser, parsesBufferedRequest) {
+  HttpParser parser;
+  HttpRequest request;
+
+  ASSERT_EQ(POST_REQUEST.size(), parser.parseRequest(POST_REQUEST.data(), POST_REQUEST.size(), request));
+  ASSERT_EQ("POST", request.getMethod());
+  ASSERT_EQ("/getblocks.bin", request.getUrl());
+  ASSERT_EQ("HTTP/1.1", request.getVersion());
+  ASSERT_EQ("5", request.getHeaders().at("content-length"));
+  ASSERT_EQ("trailers", request.getHeaders().at("te"));
+  ASSERT_EQ("hello", request.getBody());
+}
+
+TEST(HttpParser, waitsForWholeRequest) {
+  HttpParser parser;
+
+  for (size_t size = 0; size < POST_REQUEST.size(); ++size) {
+    HttpRequest request;
+    ASSERT_EQ(0, parser.parseRequest(POST_REQUEST.data(), size, request));
+  }
+}
+
+TEST(HttpParser, parsesPipelinedRequests) {
+  std::string getRequest = "GET /getinfo HTTP/1.1\r\n\r\n";
+  std::string data = POST_REQUEST + getRequest;
+
+  HttpParser parser;
+  HttpRequest first;
+  size_t firstSize = parser.parseRequest(data.data(), data.size(), first);
+  ASSERT_EQ(POST_REQUEST.size(), firstSize);
+
+  HttpRequest second;
+  ASSERT_EQ(getRequest.size(), parser.parseRequest(data.data() + firstSize, data.size() - firstSize, second));
+  ASSERT_EQ("GET", second.getMethod());
+  ASSERT_EQ("/getinfo", second.getUrl());
+  ASSERT_TRUE(second.getHeaders().empty());
+  ASSERT_TRUE(second.getBody().empty());
+}
+
+TEST(HttpParser, rejectsMalformedRequest) {
+  HttpParser parser;
+  HttpRequest request;
+
+  std::string noVersion = "GET /getinfo\r\n\r\n";
+  ASSERT_THROW(parser.parseRequest(noVersion.data(), noVersion.size(), request), std::system_error);
+
+  std::string badHeader = "GET /getinfo HTTP/1.1\r\nHost\r\n\r\n";
+  ASSERT_THROW(parser.parseRequest(badHeader.data(), badHeader.size(), request), std::system_error);
+
+  std::string hugeHeader = "GET /getinfo HTTP/1.1\r\nX: " + std::string(100 * 1024, 'x');
+  ASSERT_THROW(parser.parseRequest(hugeHeader.data(), hugeHeader.size(), request), std::system_error);
+}
+
+TEST(HttpParser, resumesRequestWithBodyReadLater) {
+  HttpParser parser;
+  HttpRequest request;
+
+  size_t headSize = POST_REQUEST.size() - 5;
+  ASSERT_EQ(0, parser.parseRequest(POST_REQUEST.data(), headSize, request));
+  ASSERT_EQ(0, parser.parseRequest(POST_REQUEST.data(), headSize + 2, request));
+  ASSERT_EQ(POST_REQUEST.size(), parser.parseRequest(POST_REQUEST.data(), POST_REQUEST.size(), request));
+  ASSERT_EQ("/getblocks.bin", request.getUrl());
+  ASSERT_EQ("hello", request.getBody());
+}
+
+TEST(HttpParser, rejectsInvalidContentLength) {
+  HttpParser parser;
+  HttpRequest request;
+
+  for (const std::string& length : { "abc", "-1", "5x", "99999999999999999999999" }) {
+    std::string data = "POST / HTTP/1.1\r\nContent-Length: " + length + "\r\n\r\n";
+    try {
+      parser.parseRequest(data.data(), data.size(), request);
+      FAIL() << length;
+    } catch (std::system_error& e) {
+      ASSERT_EQ(make_error_code(error::HttpParserErrorCodes::INVALID_LENGTH), e.code()) << length;
+    }
+  }
+
+  std::string getRequest = "GET /getinfo HTTP/1.1\r\n\r\n";
+  ASSERT_EQ(getRequest.size(), parser.parseRequest(getRequest.data(), getRequest.size(), request));
+}
+
+TEST(HttpParser, rejectsTooLargeBody) {
+  HttpParser parser;
+  HttpRequest request;
+
+  std::string data = "POST / HTTP/1.1\r\nContent-Length: 1000000000\r\n\r\n";
+  try {
+    parser.parseRequest(data.data(), data.size(), request);
+    FAIL();
+  } catch (std::system_error& e) {
+    ASSERT_EQ(make_error_code(error::HttpParserErrorCodes::BODY_TOO_LARGE), e.code());
+  }
+}
+
+TEST(HttpParser, rejectsInvalidChunkSize) {
+  std::istringstream stream(
+    "HTTP/1.1 200 OK\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "zz\r\nhello\r\n"
+    "0\r\n"
+    "\r\n");
+
+  HttpParser parser;
+  HttpResponse response;
+  ASSERT_THROW(parser.receiveResponse(stream, response), std::system_error);
+}
+
+TEST(HttpParser, receivesChunkedResponse) {
+  std::istringstream stream(
+    "HTTP/1.1 200 OK\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "5\r\nhello\r\n"
+    "7;ext=1\r\n, world\r\n"
+    "0\r\n"
+    "\r\n");
+
+  HttpParser parser;
+  HttpResponse response;
+  parser.receiveResponse(stream, response);
+
+  ASSERT_EQ(HttpResponse::STATUS_200, response.getStatus());
+  ASSERT_EQ("hello, world", response.getBody());
+}
+
+TEST(HttpParser, receivesResponseWithLength) {
+  std::istringstream stream(
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "hello");
+
+  HttpParser parser;
+  HttpResponse response;
+  parser.receiveResponse(stream, response);
+
+  ASSERT_EQ("hello", response.getBody());
+}
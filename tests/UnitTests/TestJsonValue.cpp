@@ -5,6 +5,8 @@
 #include "gtest/gtest.h"
 #include <Common/JsonValue.h>
 
+#include <sstream>
+
 using Common::JsonValue;
 
 namespace {
@@ -52,3 +54,43 @@ TEST(JsonValue, testBadPatterns) {
   }
 }
 
+
+namespace {
+
+std::vector<std::string> parsedPatterns{
+  "{\"b\": [1, -20, 3.5, -0.25, 1.5e3, 2.0e-2, true, false, null], \"a\": {\"x\": \"y\"}}",
+  "  [ \"with spaces\", \"escaped \\\" quote\", [], {}, [[1], [2, [3]]] ]  ",
+  "{\"prop\": 1, \"prop\": 2}",
+  "9223372036854775807",
+  "-9223372036854775808",
+  "0.1",
+};
+
+JsonValue readFromStream(const std::string& text, bool keepWhiteSpaces) {
+  JsonValue value;
+  std::istringstream stream(text);
+  if (keepWhiteSpaces) {
+    stream >> std::noskipws;
+  }
+
+  stream >> value;
+  return value;
+}
+
+}
+
+TEST(JsonValue, fromStringReadsAsStream) {
+  for (const auto& p : parsedPatterns) {
+    ASSERT_EQ(readFromStream(p, false).toString(), JsonValue::fromString(p).toString()) << p;
+    ASSERT_EQ(readFromStream(p, true).toString(), JsonValue::fromStringWithWhiteSpaces(p).toString()) << p;
+  }
+}
+
+TEST(JsonValue, fromStringDropsWhiteSpacesInStrings) {
+  ASSERT_EQ("with spaces", JsonValue::fromStringWithWhiteSpaces("\"with spaces\"").getString());
+  ASSERT_EQ("withspaces", JsonValue::fromString("\"with spaces\"").getString());
+}
+
+TEST(JsonValue, toStringPrintsNumbers) {
+  ASSERT_EQ("[1.5,-0.25,100.0,0.33333333333,-9223372036854775808]", JsonValue::fromString("[1.5,-0.25,100.0,0.333333333333333,-9223372036854775808]").toString());
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2011-2016 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Rpc/RpcResponseCache.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+struct TestValue {
+  int value;
+  size_t size;
+
+  size_t memorySize() const { return size; }
+};
+
+typedef RpcResponseCache<uint32_t, TestValue> TestCache;
+
+TestCache::ValuePtr makeValue(int value, size_t size = 10) {
+  return std::make_shared<const TestValue>(TestValue{ value, size });
+}
+
+bool alwaysValid(const TestValue&) {
+  return true;
+}
+
+}
+
+TEST(RpcResponseCache, computesValueOnce) {
+  TestCache cache(1000);
+  size_t computations = 0;
+  auto compute = [&] { ++computations; return makeValue(1); };
+
+  ASSERT_EQ(1, cache.get(1, alwaysValid, compute)->value);
+  ASSERT_EQ(1, cache.get(1, alwaysValid, compute)->value);
+  ASSERT_EQ(1, computations);
+  ASSERT_EQ(1, cache.count());
+}
+
+TEST(RpcResponseCache, recomputesRejectedValue) {
+  TestCache cache(1000);
+  int current = 1;
+  auto isValid = [&](const TestValue& value) { return value.value == current; };
+  auto compute = [&] { return makeValue(current); };
+
+  ASSERT_EQ(1, cache.get(1, isValid, compute)->value);
+  current = 2;
+  ASSERT_EQ(2, cache.get(1, isValid, compute)->value);
+  ASSERT_EQ(1, cache.count());
+  ASSERT_EQ(11, cache.size());
+}
+
+TEST(RpcResponseCache, failedComputationIsNotCached) {
+  TestCache cache(1000);
+  ASSERT_EQ(nullptr, cache.get(1, alwaysValid, [] { return TestCache::ValuePtr(); }));
+  ASSERT_EQ(0, cache.count());
+  ASSERT_EQ(2, cache.get(1, alwaysValid, [] { return makeValue(2); })->value);
+}
+
+TEST(RpcResponseCache, evictsLeastRecentlyUsed) {
+  TestCache cache(35);
+  cache.get(1, alwaysValid, [] { return makeValue(1); });
+  cache.get(2, alwaysValid, [] { return makeValue(2); });
+  cache.get(3, alwaysValid, [] { return makeValue(3); });
+  cache.get(1, alwaysValid, [] { return makeValue(0); });
+  cache.get(4, alwaysValid, [] { return makeValue(4); });
+
+  ASSERT_EQ(3, cache.count());
+  ASSERT_LE(cache.size(), 35);
+
+  bool recomputed = false;
+  cache.get(2, alwaysValid, [&] { recomputed = true; return makeValue(2); });
+  ASSERT_TRUE(recomputed);
+
+  recomputed = false;
+  ASSERT_EQ(1, cache.get(1, alwaysValid, [&] { recomputed = true; return makeValue(0); })->value);
+  ASSERT_FALSE(recomputed);
+}
+
+TEST(RpcResponseCache, concurrentRequestsShareComputation) {
+  TestCache cache(1000);
+  std::atomic<size_t> computations(0);
+  std::vector<std::thread> threads;
+  std::vector<int> results(8);
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&, i] {
+      results[i] = cache.get(1, alwaysValid, [&] {
+        ++computations;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        return makeValue(5);
+      })->value;
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(1, computations);
+  for (int result : results) {
+    ASSERT_EQ(5, result);
+  }
+}
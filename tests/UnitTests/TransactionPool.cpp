@@ -5,6 +5,7 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <fstream>
 
 #include <boost/filesystem/operations.hpp>
 
@@ -824,3 +825,140 @@ TEST_F(TxPool_FillBlockTemplate, TxPoolContinuesToAddOrdinaryTransactionsUpTo125
     TEST_MAX_TX_COUNT_PER_BLOCK - fusionTxCount,
     fusionTxCount));
 }
+
+TEST_F(tx_pool, TxPoolEvictsTransactionWithLowestFeeWhenFull) {
+  TransactionValidator validator;
+  FakeTimeProvider timeProvider;
+  core mycore(currency, nullptr, logger, false);
+  std::unique_ptr<tx_memory_pool> pool(new tx_memory_pool(currency, validator, mycore, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+
+  const uint64_t fee = currency.minimumFee();
+  Transaction cheapTx;
+  GenerateTransaction(currency, cheapTx, fee, 1);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(cheapTx, tvc, false, 0));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+
+  uint64_t singleTxUsage = pool->getMemoryUsage();
+  ASSERT_GT(singleTxUsage, 0);
+  pool->setMaxSize(singleTxUsage + singleTxUsage / 2);
+
+  Transaction expensiveTx;
+  GenerateTransaction(currency, expensiveTx, fee * 2, 1);
+
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(expensiveTx, tvc, false, 0));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+
+  ASSERT_EQ(1, pool->get_transactions_count());
+  ASSERT_TRUE(pool->have_tx(getObjectHash(expensiveTx)));
+  ASSERT_FALSE(pool->have_tx(getObjectHash(cheapTx)));
+  ASSERT_LE(pool->getMemoryUsage(), pool->getMaxSize());
+
+  // an evicted transaction relayed back is ignored even when there is room for it again
+  pool->setMaxSize(singleTxUsage * 4);
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(cheapTx, tvc, false, 0));
+  ASSERT_FALSE(tvc.m_added_to_pool);
+  ASSERT_FALSE(tvc.m_verifivation_failed);
+  ASSERT_FALSE(pool->have_tx(getObjectHash(cheapTx)));
+}
+
+TEST_F(tx_pool, TxPoolRejectsLowFeeTransactionWhenFull) {
+  TransactionValidator validator;
+  FakeTimeProvider timeProvider;
+  core mycore(currency, nullptr, logger, false);
+  std::unique_ptr<tx_memory_pool> pool(new tx_memory_pool(currency, validator, mycore, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+
+  const uint64_t fee = currency.minimumFee();
+  Transaction expensiveTx;
+  GenerateTransaction(currency, expensiveTx, fee * 2, 1);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(expensiveTx, tvc, false, 0));
+  ASSERT_TRUE(tvc.m_added_to_pool);
+
+  pool->setMaxSize(pool->getMemoryUsage());
+
+  Transaction cheapTx;
+  GenerateTransaction(currency, cheapTx, fee, 1);
+
+  tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(cheapTx, tvc, false, 0));
+  ASSERT_FALSE(tvc.m_added_to_pool);
+  ASSERT_FALSE(tvc.m_should_be_relayed);
+  ASSERT_FALSE(tvc.m_verifivation_failed);
+
+  ASSERT_EQ(1, pool->get_transactions_count());
+  ASSERT_TRUE(pool->have_tx(getObjectHash(expensiveTx)));
+}
+
+TEST_F(tx_pool, TxPoolIsRestoredFromJournalWithoutDeinit) {
+  TransactionValidator validator;
+  FakeTimeProvider timeProvider;
+  core mycore(currency, nullptr, logger, false);
+  std::unique_ptr<tx_memory_pool> pool(new tx_memory_pool(currency, validator, mycore, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+
+  Transaction keptTx;
+  GenerateTransaction(currency, keptTx, currency.minimumFee(), 1);
+  Transaction takenTx;
+  GenerateTransaction(currency, takenTx, currency.minimumFee(), 2);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(keptTx, tvc, false, 0));
+  ASSERT_TRUE(pool->add_tx(takenTx, tvc, false, 0));
+
+  Transaction txOut;
+  size_t blobSize;
+  uint64_t fee;
+  ASSERT_TRUE(pool->take_tx(getObjectHash(takenTx), txOut, blobSize, fee));
+
+  // simulate a crash: the pool is destroyed without deinit
+  pool.reset(new tx_memory_pool(currency, validator, mycore, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+
+  ASSERT_EQ(1, pool->get_transactions_count());
+  ASSERT_TRUE(pool->have_tx(getObjectHash(keptTx)));
+
+  Transaction restoredTx;
+  ASSERT_TRUE(pool->getTransaction(getObjectHash(keptTx), restoredTx));
+  ASSERT_EQ(keptTx, restoredTx);
+}
+
+TEST_F(tx_pool, TxPoolIgnoresDamagedJournalTail) {
+  TransactionValidator validator;
+  FakeTimeProvider timeProvider;
+  core mycore(currency, nullptr, logger, false);
+  std::unique_ptr<tx_memory_pool> pool(new tx_memory_pool(currency, validator, mycore, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+
+  Transaction tx;
+  GenerateTransaction(currency, tx, currency.minimumFee(), 1);
+
+  tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+  ASSERT_TRUE(pool->add_tx(tx, tvc, false, 0));
+  ASSERT_TRUE(pool->deinit());
+  pool.reset();
+
+  {
+    std::ofstream journal((m_configDir / currency.txPoolLogFileName()).string(), std::ios_base::binary | std::ios_base::app);
+    journal.write("\x01\xff\xff", 3);
+  }
+
+  pool.reset(new tx_memory_pool(currency, validator, mycore, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+  ASSERT_EQ(1, pool->get_transactions_count());
+
+  Transaction otherTx;
+  GenerateTransaction(currency, otherTx, currency.minimumFee(), 1);
+  ASSERT_TRUE(pool->add_tx(otherTx, tvc, false, 0));
+  ASSERT_TRUE(pool->deinit());
+
+  pool.reset(new tx_memory_pool(currency, validator, mycore, timeProvider, logger, false));
+  ASSERT_TRUE(pool->init(m_configDir.string()));
+  ASSERT_EQ(2, pool->get_transactions_count());
+}